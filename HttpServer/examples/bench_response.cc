@@ -0,0 +1,72 @@
+// 响应序列化微基准: 测量 HttpResponse::appendToBuffer 每次调用的耗时
+// 编译: cmake -DHTTP_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release .. && make bench_response
+// 运行: ./bench_response [次数]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "http/HttpResponse.h"
+
+namespace
+{
+
+// 每次序列化后清空缓冲区，和服务器中每个读事件复用同一块输出缓冲区的情况一致
+template <typename Fill>
+void run(const char* name, int iterations, Fill fill)
+{
+    muduo::net::Buffer buf;
+    size_t bytes = 0;
+
+    // 预热，让缓冲区扩容到稳定大小
+    for (int i = 0; i < 1000; ++i)
+    {
+        fill(&buf);
+        buf.retrieveAll();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fill(&buf);
+        bytes += buf.readableBytes();
+        buf.retrieveAll();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << ": " << static_cast<double>(elapsed) / iterations << " ns/op, "
+              << bytes / iterations << " bytes/op" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    // 典型的JSON接口响应
+    http::HttpResponse json(false);
+    json.setStatusLine("HTTP/1.1", http::HttpResponse::k200Ok, "OK");
+    json.setContentType("application/json");
+    json.addHeader("Cache-Control", "no-store");
+    json.addHeader("Set-Cookie", "sessionId=0123456789abcdef0123456789abcdef; Path=/; HttpOnly");
+    json.setBody("{\"success\":true,\"userId\":42,\"message\":\"ok\"}");
+    json.setContentLength(json.body().size());
+
+    // 静态资源的条件请求命中
+    http::HttpResponse notModified(false);
+    notModified.setStatusLine("HTTP/1.1", http::HttpResponse::k304NotModified, "Not Modified");
+    notModified.setETag("\"5f3a1c2b-1c2b\"");
+    notModified.setLastModified(1700000000);
+
+    // 非标准原因短语，走拼接状态行的慢路径
+    http::HttpResponse custom(true);
+    custom.setStatusLine("HTTP/1.0", http::HttpResponse::k400BadRequest, "Invalid JSON");
+    custom.setContentLength(0);
+
+    run("json 200", iterations, [&](muduo::net::Buffer* buf) { json.appendToBuffer(buf); });
+    run("304 headers only", iterations, [&](muduo::net::Buffer* buf) { notModified.appendToBuffer(buf, false); });
+    run("custom status line", iterations, [&](muduo::net::Buffer* buf) { custom.appendToBuffer(buf); });
+    return 0;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <memory>
+
+#include <muduo/net/TcpConnection.h>
+#include <muduo/base/Timestamp.h>
+
+#include "FileBody.h"
+#include "HttpContext.h"
+#include "ResponseStream.h"
+#include "../ssl/SslConnection.h"
+
+namespace http
+{
+
+// 每个TcpConnection独占一个ConnectionState，通过conn->setContext挂在连接上
+// 连接只会在自己所属的IO线程中被访问，因此不需要共享容器，也不需要加锁
+class ConnectionState
+{
+public:
+    // 连接级别的统计信息
+    struct Stats
+    {
+        muduo::Timestamp createTime; // 连接建立时间
+        muduo::Timestamp lastActiveTime; // 最后一次收到数据或输出缓冲区排空的时间，空闲超时从这里计算
+        uint64_t         requests = 0; // 已处理的请求数
+        uint64_t         bytesReceived = 0; // 已解析的HTTP报文字节数(TLS连接为解密后的明文)
+        uint64_t         bytesSent = 0; // 发送的响应字节数
+    };
+
+    explicit ConnectionState(muduo::Timestamp createTime)
+    {
+        stats_.createTime = createTime;
+        stats_.lastActiveTime = createTime;
+    }
+
+    // 从TcpConnection上取出连接状态，O(1)，连接未初始化时返回nullptr
+    static ConnectionState* get(const muduo::net::TcpConnectionPtr& conn)
+    {
+        auto state = boost::any_cast<std::shared_ptr<ConnectionState>>(conn->getMutableContext());
+        return state ? state->get() : nullptr;
+    }
+
+    HttpContext* context()
+    { return &context_; }
+
+    ssl::SslConnection* sslConnection() const
+    { return sslConn_.get(); }
+
+    void setSslConnection(std::unique_ptr<ssl::SslConnection> sslConn)
+    { sslConn_ = std::move(sslConn); }
+
+    // 连接上的响应数据都从这里发出，TLS连接先加密，本轮事件循环结束时统一发送
+    void send(const muduo::net::TcpConnectionPtr& conn, const char* data, size_t len)
+    {
+        if (sslConn_)
+        {
+            sslConn_->send(data, len);
+        }
+        else
+        {
+            // TcpConnection::send的长度是int，2GB以上的响应体分段交给它
+            while (len > 0)
+            {
+                size_t n = std::min(len, static_cast<size_t>(INT_MAX));
+                conn->send(data, static_cast<int>(n));
+                data += n;
+                len -= n;
+            }
+        }
+    }
+
+    // 已交给send的数据发送完后关闭写端
+    void shutdown(const muduo::net::TcpConnectionPtr& conn)
+    {
+        if (sslConn_)
+        {
+            sslConn_->shutdown();
+        }
+        else
+        {
+            conn->shutdown();
+        }
+    }
+
+    // 已交给send但还没有写入socket的字节数
+    size_t pendingOutput(const muduo::net::TcpConnectionPtr& conn) const
+    {
+        return conn->outputBuffer()->readableBytes() + (sslConn_ ? sslConn_->pendingBytes() : 0);
+    }
+
+    // 有请求正在工作线程中执行时，暂停解析后续的流水线请求以保证响应顺序
+    bool requestInFlight() const
+    { return requestInFlight_; }
+
+    void setRequestInFlight(bool inFlight)
+    { requestInFlight_ = inFlight; }
+
+    // 正在发送的文件响应，发送完之前同样暂停解析后续请求
+    FileTransfer* fileTransfer() const
+    { return fileTransfer_.get(); }
+
+    void setFileTransfer(std::unique_ptr<FileTransfer> transfer)
+    { fileTransfer_ = std::move(transfer); }
+
+    // 正在推送的流式响应，结束之前同样暂停解析后续请求
+    ResponseStream* responseStream() const
+    { return responseStream_.get(); }
+
+    void setResponseStream(ResponseStreamPtr stream)
+    { responseStream_ = std::move(stream); }
+
+    // 是否可以继续处理新的请求
+    bool readyForRequest() const
+    { return !requestInFlight_ && !fileTransfer_ && !responseStream_; }
+
+    // 当前未接收完的请求(TLS连接为握手)开始的时间，没有时为无效时间
+    // 请求头和整个请求的超时都从这里开始计算，后续数据的到达不会推迟它们
+    muduo::Timestamp requestStartTime() const
+    { return requestStartTime_; }
+
+    void setRequestStartTime(muduo::Timestamp time)
+    { requestStartTime_ = time; }
+
+    // 输出缓冲区积压过多时暂停读取，排空后恢复
+    bool readPaused() const
+    { return readPaused_; }
+
+    void setReadPaused(bool paused)
+    { readPaused_ = paused; }
+
+    // 上次计入服务器输出总量的输出缓冲区大小
+    size_t bufferedOutput() const
+    { return bufferedOutput_; }
+
+    void setBufferedOutput(size_t bytes)
+    { bufferedOutput_ = bytes; }
+
+    // 上次超时检查时的待发送字节数，两次检查之间有变化说明发送仍有进展
+    size_t checkedOutput() const
+    { return checkedOutput_; }
+
+    void setCheckedOutput(size_t bytes)
+    { checkedOutput_ = bytes; }
+
+    Stats& stats()
+    { return stats_; }
+
+    const Stats& stats() const
+    { return stats_; }
+
+private:
+    HttpContext                         context_; // HTTP 请求解析器
+    std::unique_ptr<ssl::SslConnection> sslConn_; // TLS 引擎，未启用SSL时为空
+    Stats                               stats_; // 统计信息
+    bool                                requestInFlight_ = false; // 是否有请求交给了工作线程
+    std::unique_ptr<FileTransfer>       fileTransfer_; // 正在发送的文件响应
+    ResponseStreamPtr                   responseStream_; // 正在推送的流式响应
+    muduo::Timestamp                    requestStartTime_; // 当前请求开始接收的时间
+    bool                                readPaused_ = false; // 是否因输出积压暂停了读取
+    size_t                              bufferedOutput_ = 0; // 计入服务器输出总量的字节数
+    size_t                              checkedOutput_ = 0; // 上次超时检查时的待发送字节数
+};
+
+// boost::any 要求存储的类型可拷贝，因此用shared_ptr包装(只有连接本身持有它)
+using ConnectionStatePtr = std::shared_ptr<ConnectionState>;
+
+} // namespace http
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "../utils/TimingWheel.h"
+
+namespace http
+{
+
+class ConnectionState;
+
+// 连接超时设置(秒)，0表示不限制
+struct TimeoutOptions
+{
+    int idleTimeout = 60; // keep-alive连接在两个请求之间的最长空闲时间
+    int headerTimeout = 10; // 从请求的第一个字节(TLS连接从建立连接)到请求头接收完的最长时间，防止慢速请求头攻击
+    int requestTimeout = 60; // 从请求的第一个字节到请求体接收完的最长时间
+};
+
+// 因超时被关闭的连接数，所有IO线程共享
+struct TimeoutStats
+{
+    std::atomic<uint64_t> idle{0}; // 空闲超时
+    std::atomic<uint64_t> header{0}; // 请求头接收超时，已返回408
+    std::atomic<uint64_t> request{0}; // 整个请求接收超时，已返回408
+};
+
+// 每个IO线程一个，管理本线程所有连接的超时，只在所属IO线程中访问
+// 连接有活动时只更新ConnectionState中的时间(O(1))，不移动时间轮中的登记；
+// 时间轮走到登记的槽时才根据连接的当前状态计算截止时间，未到期的按新的截止时间重新登记
+// 只有工作线程中执行的请求和等待应用推送数据的流式响应不计超时；
+// 输出积压(暂停读取、发送文件、流式响应)时按空闲超时处理，对端长时间不读取的连接会被关闭
+class ConnectionTimer : muduo::noncopyable
+{
+public:
+    ConnectionTimer(const TimeoutOptions& options, TimeoutStats* stats);
+
+    // 登记新建立的连接，连接状态必须已挂在连接上
+    void add(const muduo::net::TcpConnectionPtr& conn);
+
+    // 由所属IO线程的定时器每秒调用一次
+    void tick();
+
+private:
+    enum Reason
+    {
+        kIdle,
+        kHeader,
+        kRequest,
+    };
+
+    // 检查一个连接，返回新的截止时间(秒)，连接已断开或因超时被关闭时返回0
+    int64_t check(const std::weak_ptr<muduo::net::TcpConnection>& weakConn, int64_t nowSec);
+    // 根据连接当前所处的阶段计算截止时间，返回0表示不限制
+    int64_t deadline(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state, Reason* reason) const;
+    void expire(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state, Reason reason);
+
+private:
+    TimeoutOptions                                        options_;
+    TimeoutStats*                                         stats_;
+    int                                                   recheckInterval_; // 暂无超时限制的连接的重新检查间隔(秒)
+    TimingWheel<std::weak_ptr<muduo::net::TcpConnection>> wheel_;
+};
+
+} // namespace http
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Buffer.h>
+
+namespace http
+{
+
+// 以文件作为响应体，文件在打开期间一直持有fd，发送时按块pread，不整体读入内存
+class FileBody : muduo::noncopyable
+{
+public:
+    // [first, last] 闭区间，与 Range 头的语义一致
+    using ByteRange = std::pair<off_t, off_t>;
+
+    enum RangeResult
+    {
+        kNoRange, // 没有Range头或格式不合法，按整个文件响应
+        kSatisfiable, // 至少有一个范围落在文件内
+        kUnsatisfiable, // 所有范围都超出文件，需返回416
+    };
+
+    // 打开普通文件，失败时返回nullptr
+    static std::shared_ptr<FileBody> open(const std::string& path);
+
+    ~FileBody();
+
+    const std::string& path() const
+    { return path_; }
+
+    off_t size() const
+    { return size_; }
+
+    time_t lastModified() const
+    { return lastModified_; }
+
+    // 从offset处读取最多len字节，返回实际读取的字节数，出错返回-1
+    ssize_t read(off_t offset, char* buf, size_t len) const;
+
+    // 解析 "bytes=0-99,200-,-50" 形式的Range头，重叠或相邻的区间合并后按起始位置放入ranges
+    static RangeResult parseRange(std::string_view header, off_t fileSize, std::vector<ByteRange>* ranges);
+
+private:
+    FileBody(const std::string& path, int fd, off_t size, time_t lastModified);
+
+private:
+    std::string path_;
+    int         fd_;
+    off_t       size_;
+    time_t      lastModified_;
+};
+
+// 一个正在发送的文件响应: 依次发送每一段的前缀(如multipart分段头)和文件区间
+class FileTransfer
+{
+public:
+    struct Segment
+    {
+        std::string prefix; // 文件数据之前的内存数据
+        off_t       offset = 0; // 文件区间起始位置
+        size_t      length = 0; // 文件区间长度，为0时只发送前缀
+    };
+
+    FileTransfer(std::shared_ptr<FileBody> file, bool close)
+        : file_(std::move(file))
+        , close_(close)
+    {}
+
+    void addSegment(std::string prefix, off_t offset, size_t length)
+    { segments_.push_back(Segment{std::move(prefix), offset, length}); }
+
+    // 所有分段的总字节数，即响应的 Content-Length
+    size_t totalBytes() const;
+
+    // 向buf追加最多maxBytes字节的待发送数据，返回追加的字节数，读文件失败返回-1
+    ssize_t fill(muduo::net::Buffer* buf, size_t maxBytes);
+
+    bool done() const
+    { return segments_.empty(); }
+
+    // 发送完成后是否需要关闭连接
+    bool closeConnection() const
+    { return close_; }
+
+private:
+    std::shared_ptr<FileBody> file_;
+    std::deque<Segment>       segments_; // 尚未发送完的分段
+    bool                      close_;
+};
+
+} // namespace http
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
+#include <vector>
 
 #include <muduo/net/TcpServer.h>
 
@@ -14,25 +16,65 @@ class HttpContext
 public:
     enum HttpRequestParseState
     {
-        kExpectRequestLine, // 解析请求行
-        kExpectHeaders, // 解析请求头
-        kExpectBody, // 解析请求体
+        kExpectHeaders, // 等待并解析请求行和请求头
+        kExpectBody, // 解析请求体(Content-Length)
+        kExpectChunkSize, // 解析分块请求体的块大小行
+        kExpectChunkData, // 读取一个块的数据
+        kExpectChunkEnd, // 块数据之后的CRLF
+        kExpectTrailers, // 最后一个块之后的trailer，以空行结束
         kGotAll, // 解析完成
     };
     
+    enum Error
+    {
+        kNoError,
+        kBadRequest, // 语法错误，返回400
+        kPayloadTooLarge, // 请求体超过路由允许的大小，返回413
+        kInternalError, // 请求体无法写入临时文件，返回500
+    };
+
+    // 请求头解析完后查询该请求的请求体接收方式，返回的对象在请求处理期间必须有效
+    using BodyOptionsCallback = std::function<const BodyOptions& (const HttpRequest&)>;
+
     HttpContext()
-    : state_(kExpectRequestLine)
+    : state_(kExpectHeaders)
+    , scanned_(0)
+    , lineScanned_(0)
+    , requestLineEnd_(0)
+    , chunkRemaining_(0)
+    , bodyOptions_(nullptr)
+    , bodyReceived_(0)
+    , error_(kNoError)
     {}
 
+    void setBodyOptionsCallback(BodyOptionsCallback cb)
+    { bodyOptionsCallback_ = std::move(cb); }
+
     bool parseRequest(muduo::net::Buffer* buf, muduo::Timestamp receiveTime);
     bool gotAll() const 
     { return state_ == kGotAll;  }
 
+    // 还没有开始接收请求体，仍在等待请求头
+    bool expectingHeaders() const
+    { return state_ == kExpectHeaders; }
+
+    // parseRequest返回false时的错误类型
+    Error error() const
+    { return error_; }
+
+    // 复用请求对象，保留它已分配的内存
     void reset()
     {
-        state_ = kExpectRequestLine;
-        HttpRequest dummyData;
-        request_.swap(dummyData);
+        state_ = kExpectHeaders;
+        scanned_ = 0;
+        lineScanned_ = 0;
+        requestLineEnd_ = 0;
+        headerOffsets_.clear();
+        chunkRemaining_ = 0;
+        bodyOptions_ = nullptr;
+        bodyReceived_ = 0;
+        error_ = kNoError;
+        request_.clear();
     }
 
     const HttpRequest& request() const
@@ -42,9 +84,38 @@ public:
     { return request_;}
 
 private:
+    // header在请求头中的偏移，输入缓冲区可能扩容移动，请求头完整后再换算成副本中的指针
+    struct HeaderOffsets
+    {
+        size_t nameBegin;
+        size_t nameEnd;
+        size_t valueBegin;
+        size_t valueEnd;
+    };
+
+    // 逐行切分已到达的请求头，找到结尾的空行时通过headEnd返回其后的位置，格式错误返回false
+    bool scanHead(const char* begin, const char* end, const char** headEnd);
+    bool processHead(const char* begin, const char* end);
     bool processRequestLine(const char* begin, const char* end);
+    // 根据Transfer-Encoding和Content-Length决定如何读取请求体
+    bool prepareBody();
+    // 增量解码chunked请求体，数据不完整时保留状态等待下次读取，格式错误返回false
+    bool parseChunked(muduo::net::Buffer* buf);
+    // 查询当前请求的请求体接收方式，需要时创建BodyReader
+    void prepareBodyOptions();
+    // 接收一段请求体: 检查大小限制，交给BodyReader、写入临时文件或追加到内存
+    bool appendBody(const char* data, size_t len);
 private:
     HttpRequestParseState state_;
+    size_t                scanned_; // 请求头中已切分完的字节数，即下一行的开头
+    size_t                lineScanned_; // 当前不完整的行中已确认没有CRLF的字节数
+    size_t                requestLineEnd_; // 请求行末尾CRLF的偏移，0表示还没有收到完整的请求行
+    std::vector<HeaderOffsets> headerOffsets_; // 已切分出的header
+    uint64_t              chunkRemaining_; // 当前块尚未读取的字节数
+    BodyOptionsCallback   bodyOptionsCallback_; // 未设置时使用默认的BodyOptions
+    const BodyOptions*    bodyOptions_; // 当前请求的请求体接收方式
+    uint64_t              bodyReceived_; // 当前请求已接收的请求体字节数
+    Error                 error_;
     HttpRequest           request_;
 };
 
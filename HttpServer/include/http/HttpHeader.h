@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string_view>
+
+namespace http
+{
+
+// 常用的标准header，解析时按名字识别一次，之后以下标直接访问
+// header名大小写不敏感，"content-length" 和 "Content-Length" 识别为同一个header
+class HttpHeader
+{
+public:
+    enum Id
+    {
+        kAccept,
+        kAcceptCharset,
+        kAcceptEncoding,
+        kAcceptLanguage,
+        kAccessControlRequestHeaders,
+        kAccessControlRequestMethod,
+        kAuthorization,
+        kCacheControl,
+        kConnection,
+        kContentEncoding,
+        kContentLength,
+        kContentType,
+        kCookie,
+        kDate,
+        kExpect,
+        kForwarded,
+        kFrom,
+        kHost,
+        kIfMatch,
+        kIfModifiedSince,
+        kIfNoneMatch,
+        kIfRange,
+        kIfUnmodifiedSince,
+        kKeepAlive,
+        kMaxForwards,
+        kOrigin,
+        kPragma,
+        kProxyAuthorization,
+        kRange,
+        kReferer,
+        kSecWebSocketKey,
+        kSecWebSocketVersion,
+        kTE,
+        kTrailer,
+        kTransferEncoding,
+        kUpgrade,
+        kUserAgent,
+        kVia,
+        kXForwardedFor,
+        kXForwardedProto,
+        kXRealIP,
+        kXRequestedWith,
+        kNumKnownHeaders,
+        kUnknown = kNumKnownHeaders // 不在上表中的自定义header
+    };
+
+    // 识别header名，查一次完美哈希表再比较一次字符串，不是已知header时返回kUnknown
+    static Id lookup(std::string_view name);
+
+    // 已知header的标准写法
+    static std::string_view name(Id id);
+
+    // 大小写不敏感的比较
+    static bool equals(std::string_view a, std::string_view b);
+};
+
+} // namespace http
@@ -1,14 +1,29 @@
 #pragma once
 
+#include <array>
 #include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include <boost/container/small_vector.hpp>
 #include <muduo/base/Timestamp.h>
 
+#include "HttpHeader.h"
+#include "RequestBody.h"
+
 namespace http
 {
 
+// 路由树匹配出的路径参数: (参数名, 参数值)
+// 参数名指向路由树节点，参数值指向请求路径，均不拷贝
+using PathParams = boost::container::small_vector<std::pair<std::string_view, std::string_view>, 4>;
+
+// 请求行和请求头由解析器整体拷贝到请求自身的缓冲区(raw_)中，只拷贝一次
+// 方法之外的路径、查询串、header名和值都是raw_中的视图，访问时不再拷贝
+// raw_和header数组在请求对象被复用时保留容量，稳定状态下解析一个GET请求不需要分配内存
 class HttpRequest
 {
 public:
@@ -16,74 +31,149 @@ public:
     {
         kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions
     };
-    
+
+    enum Version
+    {
+        kUnknown, kHttp10, kHttp11
+    };
+
+    using Header = std::pair<std::string_view, std::string_view>;
+    using Headers = boost::container::small_vector<Header, 16>;
+
     HttpRequest()
         : method_(kInvalid)
-        , version_("Unknown")
+        , version_(kUnknown)
     {
+        knownHeaders_.fill(0);
     }
-    
+
+    // 拷贝时把视图重新指向新对象的raw_
+    HttpRequest(const HttpRequest& that);
+    HttpRequest& operator=(const HttpRequest& that);
+    // vector移动时缓冲区地址不变，视图仍然有效
+    HttpRequest(HttpRequest&&) = default;
+    HttpRequest& operator=(HttpRequest&&) = default;
+
+    // 清空请求以便复用，保留已分配的容量
+    void clear();
+
+    // 把请求头原样拷贝到raw_中并返回副本的起始地址，解析器随后用副本中的指针调用下面的setter
+    const char* assignRaw(const char* data, size_t len);
+
     void setReceiveTime(muduo::Timestamp t);
     muduo::Timestamp receiveTime() const { return receiveTime_; }
-    
+
     bool setMethod(const char* start, const char* end);
     Method method() const { return method_; }
 
-    void setPath(const char* start, const char* end);
-    std::string path() const { return path_; }
+    // [start, end) 必须位于raw_中
+    void setPath(const char* start, const char* end)
+    { path_ = std::string_view(start, end - start); }
+    std::string_view path() const { return path_; }
 
     void setPathParameters(const std::string &key, const std::string &value);
     std::string getPathParameters(const std::string &key) const;
 
-    void setQueryParameters(const char* start, const char* end);
-    std::string getQueryParameters(const std::string &key) const;
-    
-    void setVersion(std::string v)
-    {
-        version_ = v;
-    }
+    // 路由树写入的路径参数，参数值是path()的视图
+    PathParams& pathParams() { return pathParams_; }
+    const PathParams& pathParams() const { return pathParams_; }
+    // 按名字查找路径参数，不存在时返回空
+    std::string_view pathParam(std::string_view key) const;
+
+    // [start, end) 必须位于raw_中，参数在查询时才按 & 和 = 切分
+    void setQueryParameters(const char* start, const char* end)
+    { query_ = std::string_view(start, end - start); }
+    std::string_view getQueryParameters(std::string_view key) const;
+
+    void setVersion(Version v)
+    { version_ = v; }
+
+    Version version() const
+    { return version_; }
 
-    std::string getVersion() const
+    // 返回静态字符串，不拷贝
+    const std::string& getVersion() const;
+
+    // 名字和值已经由分词器切分并去掉空白，[nameBegin, valueEnd) 必须位于raw_中
+    void addHeader(const char* nameBegin, const char* nameEnd, const char* valueBegin, const char* valueEnd);
+
+    // 不存在时返回空视图，同名header出现多次时返回第一个，名字大小写不敏感
+    std::string_view getHeader(std::string_view field) const;
+
+    // 已知header直接按下标取，不比较字符串
+    std::string_view getHeader(HttpHeader::Id id) const
     {
-        return version_;
+        uint16_t index = id < HttpHeader::kNumKnownHeaders ? knownHeaders_[id] : 0;
+        return index > 0 ? headers_[index - 1].second : std::string_view();
     }
-    
-    void addHeader(const char* start, const char* colon, const char* end);
-    std::string getHeader(const std::string& field) const;
 
-    const std::map<std::string, std::string>& headers() const
+    const Headers& headers() const
     { return headers_; }
 
     void setBody(const std::string& body) { content_ = body; }
-    void setBody(const char* start, const char* end) 
-    { 
-        if (end >= start) 
+    void setBody(const char* start, const char* end)
+    {
+        if (end >= start)
         {
-            content_.assign(start, end - start); 
+            content_.assign(start, end - start);
         }
     }
-    
-    std::string getBody() const
+
+    // 分块请求体按块追加
+    void appendBody(const char* data, size_t len)
+    { content_.append(data, len); }
+
+    // 内存中的请求体，请求体写入临时文件或交给BodyReader时为空
+    const std::string& getBody() const
     { return content_; }
 
+    // 超过内存阈值后请求体写入的临时文件，没有时返回nullptr
+    BodyFile* bodyFile() const
+    { return bodyFile_.get(); }
+
+    // 把已接收的内存请求体转移到临时文件中
+    void setBodyFile(std::unique_ptr<BodyFile> file)
+    {
+        bodyFile_ = std::move(file);
+        content_.clear();
+    }
+
+    // 按块接收请求体的处理器，路由没有配置时返回nullptr
+    BodyReader* bodyReader() const
+    { return bodyReader_.get(); }
+
+    void setBodyReader(std::unique_ptr<BodyReader> reader)
+    { bodyReader_ = std::move(reader); }
+
     void setContentLength(uint64_t length)
     { contentLength_ = length; }
-    
+
     uint64_t contentLength() const
     { return contentLength_; }
 
     void swap(HttpRequest& that);
 
 private:
+    using KnownHeaders = std::array<uint16_t, HttpHeader::kNumKnownHeaders>;
+
+    void copyFrom(const HttpRequest& that);
+    std::string_view rebase(std::string_view view, const HttpRequest& that) const;
+
+private:
+    std::vector<char>                            raw_; // 请求行和请求头的副本，下面的视图都指向这里
     Method                                       method_; // 请求方法
-    std::string                                  version_; // http版本
-    std::string                                  path_; // 请求路径
-    std::unordered_map<std::string, std::string> pathParameters_; // 路径参数
-    std::unordered_map<std::string, std::string> queryParameters_; // 查询参数
+    Version                                      version_; // http版本
+    std::string_view                             path_; // 请求路径
+    std::string_view                             query_; // 查询串('?'之后的部分)
+    std::unordered_map<std::string, std::string> pathParameters_; // 路径参数(正则路由)
+    PathParams                                   pathParams_; // 路径参数(路由树)
     muduo::Timestamp                             receiveTime_; // 接收时间
-    std::map<std::string, std::string>           headers_; // 请求头
+    Headers                                      headers_; // 请求头，按出现顺序
+    KnownHeaders                                 knownHeaders_; // 已知header在headers_中的下标+1，0表示没有
     std::string                                  content_; // 请求体
+    std::shared_ptr<BodyFile>                    bodyFile_; // 写入临时文件的请求体，拷贝请求时共享
+    std::shared_ptr<BodyReader>                  bodyReader_; // 按块接收请求体的处理器
     uint64_t                                     contentLength_ { 0 }; // 请求体长度
-};  
+};
 
-} // namespace http
\ No newline at end of file
+} // namespace http
@@ -1,25 +1,45 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <boost/container/small_vector.hpp>
 #include <muduo/net/TcpServer.h>
 
+#include "FileBody.h"
+#include "HttpHeader.h"
+#include "ResponseStream.h"
+#include "../utils/HttpDate.h"
+
 namespace http
 {
 
 class HttpResponse 
 {
 public:
+    // 响应头按设置顺序存放，常见响应的header都在对象内部，不需要额外分配
+    using Header = std::pair<std::string, std::string>;
+    using Headers = boost::container::small_vector<Header, 8>;
+
     enum HttpStatusCode
     {
         kUnknown,
         k200Ok = 200,
         k204NoContent = 204,
+        k206PartialContent = 206,
         k301MovedPermanently = 301,
+        k304NotModified = 304,
         k400BadRequest = 400,
         k401Unauthorized = 401,
         k403Forbidden = 403,
         k404NotFound = 404,
+        k408RequestTimeout = 408,
         k409Conflict = 409,
+        k413PayloadTooLarge = 413,
+        k416RangeNotSatisfiable = 416,
         k500InternalServerError = 500,
+        k503ServiceUnavailable = 503,
     };
 
     HttpResponse(bool close = true)
@@ -50,30 +70,114 @@ public:
     void setContentLength(uint64_t length)
     { addHeader("Content-Length", std::to_string(length)); }
 
-    void addHeader(const std::string& key, const std::string& value)
-    { headers_[key] = value; }
+    // 同名header(大小写不敏感)已存在时覆盖其值
+    void addHeader(const std::string& key, const std::string& value);
+
+    // 设置强校验器，value需包含双引号，如 "\"5f3a-1c2b\""
+    void setETag(const std::string& etag)
+    { addHeader("ETag", etag); }
+
+    void setLastModified(time_t lastModified)
+    { addHeader("Last-Modified", formatHttpDate(lastModified)); }
+
+    // 获取已设置的响应头，不存在时返回空串
+    const std::string& getHeader(const std::string& key) const;
+
+    const Headers& headers() const
+    { return headers_; }
     
     void setBody(const std::string& body)
     { 
         body_ = body;
+        sharedBody_.reset();
+        file_.reset();
+        stream_ = nullptr;
         // body_ += "\0";
     }
 
+    // 设置共享的只读响应体(如静态资源缓存中的文件内容)，只增加引用计数，不拷贝
+    void setBody(std::shared_ptr<const std::string> body)
+    {
+        body_.clear();
+        sharedBody_ = std::move(body);
+        file_.reset();
+        stream_ = nullptr;
+    }
+
+    // 设置文件响应体，由HttpServer按块读取并发送，同时处理 Range 请求
+    // Content-Length 由发送时实际的范围决定，不需要调用 setContentLength
+    void setFileBody(std::shared_ptr<FileBody> file)
+    {
+        body_.clear();
+        sharedBody_.reset();
+        file_ = std::move(file);
+        stream_ = nullptr;
+    }
+
+    // 设置流式响应体，响应头发出后服务器在IO线程中调用start，处理器之后通过ResponseStream推送数据
+    // 长度事先未知，不需要调用 setContentLength
+    void setStreamBody(ResponseStream::StartCallback start)
+    {
+        clearBody();
+        stream_ = std::move(start);
+    }
+
+    // 丢弃响应体(304响应)，已设置的响应头保持不变
+    void clearBody()
+    {
+        body_.clear();
+        sharedBody_.reset();
+        file_.reset();
+        stream_ = nullptr;
+    }
+
+    const std::shared_ptr<FileBody>& fileBody() const
+    { return file_; }
+
+    bool isFile() const
+    { return file_ != nullptr; }
+
+    bool isStream() const
+    { return stream_ != nullptr; }
+
+    const ResponseStream::StartCallback& streamCallback() const
+    { return stream_; }
+
+    const std::string& body() const
+    { return sharedBody_ ? *sharedBody_ : body_; }
+
+    // 取走响应体交给发送队列，body_通过移动转为共享指针，不拷贝内容
+    std::shared_ptr<const std::string> releaseBody()
+    {
+        std::shared_ptr<const std::string> body = sharedBody_ 
+            ? std::move(sharedBody_) : std::make_shared<const std::string>(std::move(body_));
+        clearBody();
+        return body;
+    }
+
     void setStatusLine(const std::string& version,
                          HttpStatusCode statusCode,
                          const std::string& statusMessage);
 
     void setErrorHeader(){}
 
-    void appendToBuffer(muduo::net::Buffer* outputBuf) const;
+    // 先算出总长度，再把状态行、响应头和响应体一次写入outputBuf的连续空间
+    // 标准原因短语的状态行是预先拼好的，Date头取自当前线程的缓存
+    // withBody为false时只输出状态行和响应头(HEAD请求)
+    void appendToBuffer(muduo::net::Buffer* outputBuf, bool withBody = true) const;
+
+    // 状态码的标准原因短语，未知状态码返回空串
+    static const char* reasonPhrase(HttpStatusCode code);
 private:
     std::string                        httpVersion_; 
     HttpStatusCode                     statusCode_;
     std::string                        statusMessage_;
     bool                               closeConnection_;
-    std::map<std::string, std::string> headers_;
+    Headers                            headers_;
     std::string                        body_;
-    bool                               isFile_;
+    std::shared_ptr<const std::string> sharedBody_; // 共享响应体，非空时优先于body_
+    std::shared_ptr<FileBody>          file_; // 文件响应体，非空时body_不使用
+    ResponseStream::StartCallback      stream_; // 流式响应体，非空时body_不使用
 };
 
 } // namespace http
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+namespace http
+{
+
+// HTTP报文分词器，按16/32字节一批查找分隔符
+// 启动时通过CPUID选择AVX2、SSE4.2或逐字节的实现，不需要额外的编译选项
+namespace scanner
+{
+
+// 一行header解析出的各部分，均指向输入缓冲区，值已去掉首尾空白
+struct HeaderSpan
+{
+    const char* nameBegin;
+    const char* nameEnd;
+    const char* valueBegin;
+    const char* valueEnd;
+};
+
+enum LineResult
+{
+    kHeader, // 解析出一个header
+    kEmptyLine, // 空行，header结束
+    kIncomplete, // 数据不完整，需要等待更多数据
+    kBadLine, // 格式错误
+};
+
+// 在 [begin, end) 中查找第一个等于 a 或 b 的字节，找不到返回 end
+const char* findEither(const char* begin, const char* end, char a, char b);
+
+// 查找 CRLF，返回指向 '\r' 的指针，找不到返回nullptr
+const char* findCRLF(const char* begin, const char* end);
+
+// 从begin开始一次扫描解析一行header，成功时next指向下一行的开头
+LineResult parseHeaderLine(const char* begin, const char* end, HeaderSpan* span, const char** next);
+
+// 当前使用的实现: "avx2"、"sse4.2" 或 "scalar"
+const char* implementation();
+
+} // namespace scanner
+} // namespace http
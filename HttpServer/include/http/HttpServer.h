@@ -4,25 +4,35 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <muduo/net/TcpServer.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/base/Logging.h>
 
+#include "ConnectionState.h"
+#include "ConnectionTimer.h"
 #include "HttpContext.h"
 #include "HttpRequest.h"
 #include "HttpResponse.h"
+#include "OutputQueue.h"
 #include "../router/Router.h"
 #include "../session/SessionManager.h"
 #include "../middleware/MiddlewareChain.h"
 #include "../middleware/cors/CorsMiddleware.h"
+#include "../middleware/compression/CompressionMiddleware.h"
+#include "../ssl/HandshakePool.h"
 #include "../ssl/SslConnection.h"
 #include "../ssl/SslContext.h"
+#include "../worker/WorkerPool.h"
 
 class HttpRequest;
 class HttpResponse;
@@ -30,22 +40,68 @@ class HttpResponse;
 namespace http
 {
 
+// 服务器级别的连接数和输出缓冲区限制
+struct ConnectionLimits
+{
+    size_t maxConnections = 0; // 最大连接数，超过后新连接直接返回503并关闭，0表示不限制
+    size_t highWaterMark = 1024 * 1024; // 单个连接输出缓冲区的高水位，超过后暂停读取和解析该连接的请求，排空后恢复
+    size_t maxOutputBytes = 0; // 所有连接输出缓冲区合计的上限，超过后仍有数据未发完的连接暂停读取，0表示不限制
+};
+
 class HttpServer : muduo::noncopyable
 {
 public:
-    using HttpCallback = std::function<void (const http::HttpRequest&, http::HttpResponse*)>;
+    // 请求在整个处理链中原地传递，中间件和路由直接修改它，不做拷贝
+    using HttpCallback = std::function<void (http::HttpRequest&, http::HttpResponse*)>;
+
+    // 阻塞路由的统计快照
+    struct RouteStatsSnapshot
+    {
+        HttpRequest::Method method;
+        std::string         path;
+        int64_t             queueDepth; // 当前排队中的请求数
+        uint64_t            completed; // 已完成的请求数
+        uint64_t            rejected; // 因队列已满被拒绝的请求数
+        int64_t             avgWaitUs; // 平均排队时间(微秒)
+        int64_t             maxWaitUs; // 最长排队时间(微秒)
+    };
     
     // 构造函数
     HttpServer(int port,
                const std::string& name,
                bool useSSL = false,
                muduo::net::TcpServer::Option option = muduo::net::TcpServer::kNoReusePort);
+    ~HttpServer();
     
     void setThreadNum(int numThreads)
     {
         server_.setThreadNum(numThreads);
     }
 
+    // 设置执行阻塞路由的工作线程数，为0时阻塞路由仍在IO线程中执行
+    void setWorkerThreadNum(int numThreads)
+    {
+        numWorkerThreads_ = numThreads;
+    }
+
+    // 设置工作线程池的最大排队数，超过后直接返回503
+    void setWorkerQueueSize(size_t maxSize)
+    {
+        workerPool_.setMaxQueueSize(maxSize);
+    }
+
+    // 设置执行TLS握手计算的线程数，为0时握手在IO线程中执行，需在start之前调用
+    void setHandshakeThreadNum(int numThreads)
+    {
+        numHandshakeThreads_ = numThreads;
+    }
+
+    // 设置同时进行的TLS握手数上限，超过后新连接直接关闭，0表示不限制，需在start之前调用
+    void setMaxHandshakes(size_t maxHandshakes)
+    {
+        maxHandshakes_ = maxHandshakes;
+    }
+
     void start();
 
     muduo::net::EventLoop* getLoop() const 
@@ -58,36 +114,117 @@ public:
         httpCallback_ = cb;
     }
 
-    // 注册静态路由处理器
-    void Get(const std::string& path, const HttpCallback& cb)
+    // 注册静态路由处理器，blocking为true时处理器在工作线程池中执行
+    void Get(const std::string& path, const router::Router::HandlerCallback& cb, bool blocking = false)
     {
         router_.registerCallback(HttpRequest::kGet, path, cb);
+        if (blocking) setBlockingRoute(HttpRequest::kGet, path);
     }
     
     // 注册静态路由处理器
-    void Get(const std::string& path, router::Router::HandlerPtr handler)
+    void Get(const std::string& path, router::Router::HandlerPtr handler, bool blocking = false)
     {
         router_.registerHandler(HttpRequest::kGet, path, handler);
+        if (blocking) setBlockingRoute(HttpRequest::kGet, path);
     }
 
-    void Post(const std::string& path, const HttpCallback& cb)
+    void Post(const std::string& path, const router::Router::HandlerCallback& cb, bool blocking = false)
     {
         router_.registerCallback(HttpRequest::kPost, path, cb);
+        if (blocking) setBlockingRoute(HttpRequest::kPost, path);
     }
 
-    void Post(const std::string& path, router::Router::HandlerPtr handler)
+    void Post(const std::string& path, router::Router::HandlerPtr handler, bool blocking = false)
     {
         router_.registerHandler(HttpRequest::kPost, path, handler);
+        if (blocking) setBlockingRoute(HttpRequest::kPost, path);
+    }
+
+    // 将路由标记为阻塞路由(数据库访问、耗时计算等)，其处理器交给工作线程池执行，
+    // 执行完成后响应再通过 EventLoop::runInLoop 回到连接所属的IO线程发送
+    void setBlockingRoute(HttpRequest::Method method, const std::string& path);
+
+    // 设置未单独配置的路由的请求体接收方式(大小上限、落盘阈值)
+    void setDefaultBodyOptions(const BodyOptions& options)
+    {
+        defaultBodyOptions_ = options;
     }
 
-    // 注册动态路由处理器
+    // 为路由单独设置请求体接收方式，如上传接口放宽大小上限或按块接收请求体，需在start之前调用
+    // path可以是精确路径，也可以是与addRoute相同的路径模式(/upload/:id、/files/*path)，精确路径优先
+    void setBodyOptions(HttpRequest::Method method, const std::string& path, const BodyOptions& options);
+
+    // 设置空闲、请求头接收和整个请求接收的超时时间，需在start之前调用，全部为0时不检查超时
+    void setTimeoutOptions(const TimeoutOptions& options)
+    {
+        timeoutOptions_ = options;
+    }
+
+    // 设置连接数和输出缓冲区限制，需在start之前调用
+    void setConnectionLimits(const ConnectionLimits& limits)
+    {
+        limits_ = limits;
+    }
+
+    // 当前连接数
+    size_t numConnections() const
+    {
+        return numConnections_.load();
+    }
+
+    // 因超过最大连接数被拒绝的连接数
+    uint64_t rejectedConnections() const
+    {
+        return rejectedConnections_.load();
+    }
+
+    // 所有连接输出缓冲区中积压的字节数
+    int64_t bufferedOutputBytes() const
+    {
+        return outputBytes_.load();
+    }
+
+    // TLS握手统计(完整握手与恢复会话的次数)，未启用SSL时全部为0
+    ssl::SslStats getSslStats() const
+    {
+        return sslCtx_ ? sslCtx_->stats() : ssl::SslStats();
+    }
+
+    // 握手并发数、被拒绝的连接数和握手线程的排队情况，未启用握手线程和并发上限时全部为0
+    ssl::HandshakeStats getHandshakeStats() const
+    {
+        return handshakePool_ ? handshakePool_->stats() : ssl::HandshakeStats();
+    }
+
+    // 因超时被关闭的连接数
+    const TimeoutStats& getTimeoutStats() const
+    {
+        return timeoutStats_;
+    }
+
+    // 获取所有阻塞路由的排队统计
+    std::vector<RouteStatsSnapshot> getBlockingRouteStats() const;
+
+    // 注册动态路由处理器，路径模式支持 :name 和 *name，参数通过 req.pathParam("name") 获取
     void addRoute(HttpRequest::Method method, const std::string& path, router::Router::HandlerPtr handler)
     {
-        router_.addRegexHandler(method, path, handler);
+        router_.addRoute(method, path, handler);
     }
 
     // 注册动态路由处理函数
     void addRoute(HttpRequest::Method method, const std::string& path, const router::Router::HandlerCallback& callback)
+    {
+        router_.addRoute(method, path, callback);
+    }
+
+    // 注册正则动态路由处理器，参数依次命名为 param1..N，仅在路由树无法表达时使用
+    void addRegexRoute(HttpRequest::Method method, const std::string& path, router::Router::HandlerPtr handler)
+    {
+        router_.addRegexHandler(method, path, handler);
+    }
+
+    // 注册正则动态路由处理函数
+    void addRegexRoute(HttpRequest::Method method, const std::string& path, const router::Router::HandlerCallback& callback)
     {
         router_.addRegexCallback(method, path, callback);
     }
@@ -117,16 +254,80 @@ public:
 
     void setSslConfig(const ssl::SslConfig& config);
 
+    // 添加按SNI选择的证书，需在setSslConfig之后调用，setSslConfig的证书为默认证书
+    void addSslConfig(const ssl::SslConfig& config);
+
+    // 收到SIGHUP或证书文件被修改时在后台线程重新加载证书，interval为检查文件修改的间隔(秒)
+    // 新证书只用于之后的握手，已建立的连接不受影响；需在start之前调用
+    void enableCertificateReload(double interval = 5.0)
+    {
+        certificateCheckInterval_ = interval;
+    }
+
 private:
     void initialize();
+    // 检查是否需要重新加载证书
+    void checkCertificates();
+    // 在IO线程启动时为它创建连接超时时间轮，并由该线程的定时器驱动
+    void initConnectionTimer(muduo::net::EventLoop* loop);
 
     void onConnection(const muduo::net::TcpConnectionPtr& conn);
     void onMessage(const muduo::net::TcpConnectionPtr& conn,
                    muduo::net::Buffer* buf,
                    muduo::Timestamp receiveTime);
-    void onRequest(const muduo::net::TcpConnectionPtr&, const HttpRequest&);
+    // 处理TLS连接解密缓冲区中的请求
+    void processDecrypted(const muduo::net::TcpConnectionPtr& conn,
+                          ConnectionState* state,
+                          muduo::Timestamp receiveTime);
+    // 循环解析并处理buf中所有完整的请求
+    void processRequests(const muduo::net::TcpConnectionPtr& conn,
+                         ConnectionState* state,
+                         muduo::net::Buffer* buf,
+                         muduo::Timestamp receiveTime);
+    // 处理一个完整的请求，响应追加到output中，返回是否需要关闭连接
+    bool onRequest(ConnectionState* state, HttpRequest&, OutputQueue* output);
+    // 把响应序列化到output中，大响应体只引用不拷贝，文件响应只写入响应头，文件内容交给state中的FileTransfer发送
+    bool writeResponse(ConnectionState* state,
+                       const HttpRequest& req,
+                       HttpResponse* response,
+                       OutputQueue* output);
+    // 发送output，有文件或流式响应时开始发送响应体，否则按close决定是否断开连接
+    void sendOutput(const muduo::net::TcpConnectionPtr& conn,
+                    ConnectionState* state,
+                    OutputQueue* output,
+                    bool close);
+    // 输出缓冲区为空时继续读取并发送下一块文件内容
+    void sendFileChunks(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state);
+    void onWriteComplete(const muduo::net::TcpConnectionPtr& conn);
+    // 输出缓冲区超过高水位时暂停读取，并通知流式响应暂停
+    void onHighWaterMark(const muduo::net::TcpConnectionPtr& conn, size_t bytes);
+    // 超过最大连接数时返回503并关闭连接
+    void rejectConnection(const muduo::net::TcpConnectionPtr& conn);
+    // 连接的输出缓冲区超过高水位，或服务器输出总量超过上限而它仍有数据未发完时返回true
+    bool outputBlocked(const muduo::net::TcpConnectionPtr& conn, const ConnectionState* state) const;
+    // 暂停读取，输出缓冲区排空后由onWriteComplete恢复
+    void pauseReading(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state);
+    // 把连接当前的输出缓冲区大小计入服务器输出总量
+    void updateBufferedOutput(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state);
+    // 流式响应结束后关闭连接或继续处理后续请求
+    void onStreamDone(const std::weak_ptr<muduo::net::TcpConnection>& weakConn, bool close);
+    // 继续处理之前暂停解析的流水线请求
+    void resumeRequests(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state);
+    // 将阻塞路由的请求交给工作线程池，队列已满时向output追加503，返回是否需要关闭连接
+    bool dispatchToWorker(const muduo::net::TcpConnectionPtr& conn,
+                          ConnectionState* state,
+                          worker::RouteStats* routeStats,
+                          OutputQueue* output);
+    // 工作线程执行完成后在IO线程中发送响应
+    void onWorkerComplete(const std::weak_ptr<muduo::net::TcpConnection>& weakConn,
+                          const std::shared_ptr<HttpRequest>& req,
+                          const std::shared_ptr<HttpResponse>& response);
+    // 请求头解析完后查询请求体接收方式
+    const BodyOptions& bodyOptionsFor(const HttpRequest& req) const;
+    // 查找请求对应的阻塞路由统计，非阻塞路由返回nullptr
+    worker::RouteStats* findBlockingRoute(const HttpRequest& req);
 
-    void handleRequest(const HttpRequest& req, HttpResponse* resp);
+    void handleRequest(HttpRequest& req, HttpResponse* resp);
     
 private:
     muduo::net::InetAddress                      listenAddr_; // 监听地址
@@ -138,8 +339,30 @@ private:
     middleware::MiddlewareChain                  middlewareChain_; // 中间件链
     std::unique_ptr<ssl::SslContext>             sslCtx_; // SSL 上下文
     bool                                         useSSL_; // 是否使用 SSL   
-    // TcpConnectionPtr -> SslConnectionPtr 
-    std::map<muduo::net::TcpConnectionPtr, std::unique_ptr<ssl::SslConnection>> sslConns_;
+    worker::WorkerPool                           workerPool_; // 执行阻塞路由的工作线程池
+    int                                          numWorkerThreads_; // 工作线程数
+    // 阻塞路由 -> 排队统计，只在启动前注册，运行期间只读
+    router::Router::RouteMap<std::unique_ptr<worker::RouteStats>> blockingRoutes_;
+    BodyOptions                                  defaultBodyOptions_; // 未单独配置的路由的请求体接收方式
+    // 路由 -> 请求体接收方式，只在启动前设置，运行期间只读
+    router::Router::RouteMap<BodyOptions>        bodyOptions_;
+    std::unordered_map<int, router::RadixTree>   bodyOptionTrees_; // 请求方法 -> 带参数的路径模式
+    std::vector<BodyOptions>                     patternBodyOptions_; // 路由树匹配出的下标 -> 请求体接收方式
+    TimeoutOptions                               timeoutOptions_; // 连接超时设置
+    TimeoutStats                                 timeoutStats_; // 超时关闭的连接数
+    std::mutex                                   timersMutex_; // 保护connectionTimers_，只在IO线程启动时使用
+    std::vector<std::unique_ptr<ConnectionTimer>> connectionTimers_; // 每个IO线程一个时间轮
+    ConnectionLimits                             limits_; // 连接数和输出缓冲区限制
+    std::atomic<size_t>                          numConnections_{0}; // 当前连接数
+    std::atomic<uint64_t>                        rejectedConnections_{0}; // 超过最大连接数被拒绝的连接数
+    std::atomic<int64_t>                         outputBytes_{0}; // 所有连接输出缓冲区中积压的字节数
+    double                                       certificateCheckInterval_; // 检查证书文件的间隔，0表示不自动重新加载
+    std::atomic<bool>                            reloadingCertificates_{false}; // 是否正在后台重新加载证书
+    std::thread                                  reloadThread_; // 重新加载证书的后台线程
+    int                                          numHandshakeThreads_; // 握手线程数
+    size_t                                       maxHandshakes_; // 并发握手上限
+    // 握手并发上限和握手线程，都未启用时为空，与未销毁的SslConnection共同持有
+    std::shared_ptr<ssl::HandshakePool>          handshakePool_;
 }; 
 
 } // namespace http
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Buffer.h>
+
+namespace http
+{
+
+// 一次读事件产生的待发送数据，按顺序由若干段组成
+// 状态行、响应头和小响应体追加在段内的缓冲区中；大响应体只保存共享指针，
+// 发送时直接交给连接，TcpConnection在输出缓冲区为空时直接写socket，只有写不完的部分才会被拷贝
+class OutputQueue : muduo::noncopyable
+{
+public:
+    // 返回队列尾部可追加数据的缓冲区
+    muduo::net::Buffer* buffer()
+    {
+        if (segments_.empty() || segments_.back().body)
+        {
+            segments_.emplace_back();
+        }
+        return &segments_.back().buffer;
+    }
+
+    // 追加大响应体，不拷贝内容
+    void appendBody(std::shared_ptr<const std::string> body)
+    {
+        if (body && !body->empty())
+        {
+            segments_.emplace_back();
+            segments_.back().body = std::move(body);
+        }
+    }
+
+    size_t readableBytes() const
+    {
+        size_t bytes = 0;
+        for (const Segment& segment : segments_)
+        {
+            bytes += segment.body ? segment.body->size() : segment.buffer.readableBytes();
+        }
+        return bytes;
+    }
+
+    bool empty() const
+    { return readableBytes() == 0; }
+
+    // 按顺序对每一段调用 func(const char* data, size_t len)，然后清空队列
+    template <typename Func>
+    void drain(Func&& func)
+    {
+        for (Segment& segment : segments_)
+        {
+            if (segment.body)
+            {
+                func(segment.body->data(), segment.body->size());
+            }
+            else if (segment.buffer.readableBytes() > 0)
+            {
+                func(segment.buffer.peek(), segment.buffer.readableBytes());
+            }
+        }
+        segments_.clear();
+    }
+
+private:
+    struct Segment
+    {
+        muduo::net::Buffer                 buffer;
+        std::shared_ptr<const std::string> body; // 非空时本段是大响应体，buffer不使用
+    };
+
+    std::vector<Segment> segments_;
+};
+
+} // namespace http
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <muduo/base/noncopyable.h>
+
+namespace http
+{
+
+class HttpRequest;
+
+// 超过内存阈值的请求体写入的临时文件
+// 创建后立即unlink，fd关闭后由内核回收，进程崩溃也不会留下文件
+class BodyFile : muduo::noncopyable
+{
+public:
+    // 在dir下创建临时文件，失败时返回nullptr
+    static std::unique_ptr<BodyFile> create(const std::string& dir);
+
+    ~BodyFile();
+
+    // 追加写入，写满磁盘等错误时返回false
+    // 在IO线程中同步pwrite，每次读事件收到的数据写一次，通常只写入页缓存；
+    // 临时目录所在的磁盘很慢时会阻塞同一IO线程上的其他连接，这类路由应改用readerFactory把数据交给工作线程
+    bool append(const char* data, size_t len);
+
+    // 从offset处读取最多len字节，返回实际读取的字节数，出错返回-1
+    ssize_t read(off_t offset, char* buf, size_t len) const;
+
+    uint64_t size() const
+    { return size_; }
+
+    int fd() const
+    { return fd_; }
+
+private:
+    explicit BodyFile(int fd)
+        : fd_(fd)
+        , size_(0)
+    {}
+
+private:
+    int      fd_;
+    uint64_t size_;
+};
+
+// 按块接收请求体的处理器，请求体不再保存在请求中
+// 在连接所属的IO线程中随数据到达被调用，请求体接收完后路由处理器才被调用，
+// 处理器可通过 req.bodyReader() 取回本对象读取处理结果
+class BodyReader
+{
+public:
+    virtual ~BodyReader() = default;
+
+    // 收到一段请求体，返回false时中止请求(400)
+    virtual bool onData(const char* data, size_t len) = 0;
+};
+
+// 请求头解析完后按路由确定请求体的接收方式
+struct BodyOptions
+{
+    using ReaderFactory = std::function<std::unique_ptr<BodyReader> (const HttpRequest&)>;
+
+    uint64_t      maxSize = 8 * 1024 * 1024; // 请求体最大长度，超过时返回413
+    size_t        spillThreshold = 1024 * 1024; // 超过这个大小的请求体写入临时文件(IO线程中同步写)，0表示始终保存在内存中
+    std::string   spillDir = "/tmp"; // 临时文件所在目录
+    ReaderFactory readerFactory; // 非空时请求体按块交给它创建的BodyReader
+};
+
+} // namespace http
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/TcpConnection.h>
+
+namespace http
+{
+
+// 流式响应体: 处理器通过 HttpResponse::setStreamBody 注册开始回调，服务器发出响应头后
+// 在IO线程中调用它并传入本对象，之后处理器(或它交给的其他线程)边生成边推送数据块
+// HTTP/1.1 使用 Transfer-Encoding: chunked 分块发送；HTTP/1.0 直接发送原始数据并在结束后关闭连接
+//
+// 背压: 连接输出缓冲区超过高水位，或推送后尚未交给连接的数据过多时，paused()返回true，
+// 生产者应停止推送，等输出缓冲区排空后由IO线程调用resume回调再继续。连接断开时同样会调用resume回调，
+// 生产者此时检查closed()即可退出
+//
+//     resp->setStreamBody([](const std::shared_ptr<ResponseStream>& stream) {
+//         auto produce = [stream]() {
+//             while (!stream->closed() && !stream->paused() && hasMore())
+//             {
+//                 stream->write(nextPart());
+//             }
+//             if (!hasMore()) stream->finish();
+//         };
+//         stream->setResumeCallback(produce);
+//         produce();
+//     });
+class ResponseStream : public std::enable_shared_from_this<ResponseStream>, muduo::noncopyable
+{
+public:
+    using StartCallback = std::function<void (const std::shared_ptr<ResponseStream>&)>;
+    using ResumeCallback = std::function<void ()>;
+    using DoneCallback = std::function<void ()>;
+
+    // 推送后尚未交给连接的数据超过这个大小时要求生产者暂停
+    static const size_t kMaxPendingBytes = 1024 * 1024;
+
+    ResponseStream(StartCallback start, bool chunked, bool withBody);
+
+    // 以下函数可以在任意线程调用，同一个流的数据应由一个线程按顺序推送
+
+    // 推送一块数据，连接已断开或流已结束时返回false
+    bool write(const char* data, size_t len);
+    bool write(const std::string& data)
+    { return write(data.data(), data.size()); }
+
+    // 结束响应，重复调用无效果
+    void finish();
+
+    // 是否应该暂停推送
+    bool paused();
+
+    bool closed() const
+    { return closed_; }
+
+    // 输出缓冲区排空或连接断开时在IO线程中调用，可能被多调用几次，回调需要能重入
+    void setResumeCallback(ResumeCallback cb);
+
+    // 以下函数由HttpServer在连接所属的IO线程中调用
+
+    // 响应头已发出，开始推送；流结束后调用done
+    void start(const muduo::net::TcpConnectionPtr& conn, DoneCallback done);
+    bool started() const
+    { return loop_ != nullptr; }
+
+    void onHighWaterMark();
+    void onWriteComplete();
+    void onClose();
+
+private:
+    void sendInLoop(const std::string& data);
+    void finishInLoop();
+    void resume();
+
+private:
+    StartCallback                            start_; // 发出响应头后调用一次
+    DoneCallback                             done_; // 流结束后通知服务器继续处理后续请求
+    std::weak_ptr<muduo::net::TcpConnection> conn_;
+    muduo::net::EventLoop*                   loop_; // 连接所属的IO线程，start之前为空
+    bool                                     chunked_; // 是否按chunked格式分块
+    bool                                     withBody_; // HEAD请求不发送数据，推送的数据直接丢弃
+    std::atomic<bool>                        closed_; // 连接已断开
+    std::atomic<bool>                        finished_; // 已调用finish
+    std::atomic<bool>                        highWater_; // 连接输出缓冲区超过了高水位
+    std::atomic<bool>                        waiting_; // 生产者因paused()停止，等待resume
+    std::atomic<size_t>                      pendingBytes_; // 已推送但还在IO线程队列中的字节数
+    std::mutex                               mutex_; // 保护resume_
+    ResumeCallback                           resume_;
+};
+
+using ResponseStreamPtr = std::shared_ptr<ResponseStream>;
+
+} // namespace http
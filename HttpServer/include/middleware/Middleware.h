@@ -17,7 +17,11 @@ public:
     virtual void before(HttpRequest& request) = 0;
     
     // 响应后处理
-    virtual void after(HttpResponse& response) = 0;
+    virtual void after(HttpResponse&) {}
+
+    // 需要结合请求处理响应时(如按 Accept-Encoding 协商压缩)重写这个版本，默认转发给 after(response)
+    virtual void after(const HttpRequest&, HttpResponse& response)
+    { after(response); }
     
     // 设置下一个中间件
     void setNext(std::shared_ptr<Middleware> next) 
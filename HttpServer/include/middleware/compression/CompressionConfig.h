@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace http
+{
+namespace middleware
+{
+
+struct CompressionConfig
+{
+    size_t                   minSize = 1024; // 小于这个大小的响应体不压缩，压缩收益抵不上开销
+    int                      gzipLevel = 6; // gzip/deflate 压缩级别 1-9
+    int                      brotliQuality = 5; // brotli 压缩质量 0-11
+    size_t                   maxCacheBytes = 32 * 1024 * 1024; // 预压缩缓存占用的最大字节数
+    std::vector<std::string> compressibleTypes; // 允许压缩的 Content-Type(不含参数)
+
+    static CompressionConfig defaultConfig()
+    {
+        CompressionConfig config;
+        config.compressibleTypes = {
+            "text/html", "text/css", "text/plain", "text/javascript",
+            "application/javascript", "application/json", "image/svg+xml"
+        };
+        return config;
+    }
+};
+
+} // namespace middleware
+} // namespace http
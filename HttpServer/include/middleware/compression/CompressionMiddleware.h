@@ -0,0 +1,61 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../Middleware.h"
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "CompressionConfig.h"
+
+namespace http
+{
+namespace middleware
+{
+
+// 根据 Accept-Encoding 压缩响应体，支持 br(编译时找到brotli才启用)、gzip 和 deflate
+// 带ETag的响应(静态资源)按 ETag+编码 缓存压缩结果，热点页面只压缩一次
+// 处理器可能在IO线程或工作线程中执行，缓存由互斥锁保护
+class CompressionMiddleware : public Middleware
+{
+public:
+    enum Encoding
+    {
+        kIdentity, kDeflate, kGzip, kBrotli
+    };
+
+    explicit CompressionMiddleware(const CompressionConfig& config = CompressionConfig::defaultConfig());
+
+    void before(HttpRequest&) override {}
+    using Middleware::after;
+    void after(const HttpRequest& request, HttpResponse& response) override;
+
+    // 从 Accept-Encoding 中选出服务端支持且客户端接受的最优编码
+    static Encoding negotiate(std::string_view acceptEncoding);
+
+    // 压缩data，失败时返回空串
+    std::string compress(Encoding encoding, const std::string& data) const;
+
+private:
+    bool isCompressible(const HttpResponse& response) const;
+    std::shared_ptr<const std::string> getCached(const std::string& key);
+    void putCached(const std::string& key, std::shared_ptr<const std::string> data);
+
+private:
+    using CacheList = std::list<std::pair<std::string, std::shared_ptr<const std::string>>>;
+
+    CompressionConfig                                     config_;
+    std::unordered_set<std::string>                       types_; // 允许压缩的 Content-Type
+    std::mutex                                            mutex_; // 保护下面的缓存
+    CacheList                                             lru_; // 最近使用的在前
+    std::unordered_map<std::string, CacheList::iterator>  cache_; // ETag+编码 -> 压缩结果
+    size_t                                                cacheBytes_; // 缓存的压缩数据总大小
+};
+
+} // namespace middleware
+} // namespace http
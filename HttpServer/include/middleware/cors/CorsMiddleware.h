@@ -16,6 +16,7 @@ public:
     explicit CorsMiddleware(const CorsConfig& config = CorsConfig::defaultConfig());
     
     void before(HttpRequest& request) override;
+    using Middleware::after;
     void after(HttpResponse& response) override;
 
     std::string join(const std::vector<std::string>& strings, const std::string& delimiter);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../http/HttpRequest.h"
+
+namespace http
+{
+namespace router
+{
+
+// 压缩前缀树(radix tree)，用于匹配动态路由
+// 支持的路径模式:
+//   /user/:id          ":name" 匹配一个非空路径段
+//   /static/*filepath  "*name" 匹配剩余的全部路径(只能出现在末尾)
+// 匹配优先级: 静态片段 > 命名参数 > 通配符
+class RadixTree
+{
+public:
+    static const int kNoRoute = -1;
+
+    RadixTree();
+    ~RadixTree();
+
+    // 插入路径模式，routeId为路由在外部表中的下标，模式不合法时抛出 std::invalid_argument
+    void insert(const std::string& pattern, int routeId);
+
+    // 匹配路径，成功返回routeId并把参数追加到params中，失败返回kNoRoute
+    int match(std::string_view path, PathParams& params) const;
+
+    bool empty() const
+    { return size_ == 0; }
+
+private:
+    struct Node
+    {
+        enum Type { kStatic, kParam, kWildcard };
+
+        Type                               type = kStatic;
+        std::string                        text; // 静态节点为压缩后的前缀，参数节点为参数名
+        std::string                        indices; // 各静态子节点前缀的首字符，用于快速选择子节点
+        std::vector<std::unique_ptr<Node>> children; // 静态子节点
+        std::unique_ptr<Node>              paramChild; // ":name" 子节点
+        std::unique_ptr<Node>              wildcardChild; // "*name" 子节点
+        int                                routeId = kNoRoute;
+    };
+
+    Node* insertStatic(Node* node, std::string_view text);
+    Node* insertParam(Node* node, Node::Type type, std::string_view name, const std::string& pattern);
+    int matchChildren(const Node* node, std::string_view path, PathParams& params) const;
+
+private:
+    std::unique_ptr<Node> root_;
+    size_t                size_; // 已插入的路由数
+};
+
+} // namespace router
+} // namespace http
@@ -1,12 +1,15 @@
 #pragma once
+#include <deque>
 #include <iostream>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <functional>
 #include <regex>
 #include <vector>
 
+#include "RadixTree.h"
 #include "RouterHandler.h"
 #include "../http/HttpRequest.h"
 #include "../http/HttpResponse.h"
@@ -25,11 +28,11 @@ public:
     using HandlerPtr = std::shared_ptr<RouterHandler>;
     using HandlerCallback = std::function<void(const HttpRequest &, HttpResponse *)>;
 
-    // 路由键（请求方法 + URI）
+    // 路由键（请求方法 + URI），path只是视图，查找时直接指向请求中的路径
     struct RouteKey
     {
         HttpRequest::Method method;
-        std::string path;
+        std::string_view path;
 
         bool operator==(const RouteKey &other) const
         {
@@ -48,35 +51,97 @@ public:
         size_t operator()(const RouteKey &key) const
         {
             size_t methodHash = std::hash<int>{}(static_cast<int>(key.method));
-            size_t pathHash = std::hash<std::string>{}(key.path);
+            size_t pathHash = std::hash<std::string_view>{}(key.path);
             return methodHash * 31 + pathHash;
         }
     };
 
+    // 精确匹配的路由表，键中的路径指向paths_中保存的副本，
+    // 按请求路径查找时不需要先构造std::string，不分配内存
+    template <typename T>
+    class RouteMap
+    {
+    public:
+        using Map = std::unordered_map<RouteKey, T, RouteKeyHash>;
+
+        RouteMap() = default;
+        RouteMap(const RouteMap&) = delete; // 拷贝出的键会指向原对象的paths_
+        RouteMap& operator=(const RouteMap&) = delete;
+
+        // 与unordered_map::operator[]相同，不存在时插入默认值
+        T& operator[](const RouteKey& key)
+        {
+            auto it = map_.find(key);
+            if (it == map_.end())
+            {
+                paths_.emplace_back(key.path); // deque在尾部插入不移动已有元素，已有键中的视图保持有效
+                it = map_.emplace(RouteKey{key.method, paths_.back()}, T()).first;
+            }
+            return it->second;
+        }
+
+        typename Map::iterator find(const RouteKey& key)
+        { return map_.find(key); }
+
+        typename Map::const_iterator find(const RouteKey& key) const
+        { return map_.find(key); }
+
+        typename Map::iterator begin()
+        { return map_.begin(); }
+
+        typename Map::iterator end()
+        { return map_.end(); }
+
+        typename Map::const_iterator begin() const
+        { return map_.begin(); }
+
+        typename Map::const_iterator end() const
+        { return map_.end(); }
+
+        size_t size() const
+        { return map_.size(); }
+
+        bool empty() const
+        { return map_.empty(); }
+
+    private:
+        Map                     map_;
+        std::deque<std::string> paths_; // 键中路径的存储
+    };
+
     // 注册路由处理器
     void registerHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler);
 
     // 注册回调函数形式的处理器
     void registerCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback);
 
-    // 注册动态路由处理器
+    // 注册动态路由处理器，路径模式支持 /user/:id 和 /static/*filepath，由路由树匹配
+    void addRoute(HttpRequest::Method method, const std::string &pattern, HandlerPtr handler);
+
+    // 注册动态路由处理函数
+    void addRoute(HttpRequest::Method method, const std::string &pattern, const HandlerCallback &callback);
+
+    // 注册正则动态路由处理器，逐个正则匹配，较慢，仅作为路由树无法表达时的后备
     void addRegexHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler)
     {
         std::regex pathRegex = convertToRegex(path);
         regexHandlers_.emplace_back(method, pathRegex, handler);
     }
 
-    // 注册动态路由处理函数
+    // 注册正则动态路由处理函数
     void addRegexCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback)
     {
         std::regex pathRegex = convertToRegex(path);
         regexCallbacks_.emplace_back(method, pathRegex, callback);
     }
 
-    // 处理请求
-    bool route(const HttpRequest &req, HttpResponse *resp);
+    // 处理请求，路由树匹配出的路径参数写入req.pathParams()
+    bool route(HttpRequest &req, HttpResponse *resp);
 
 private:
+    // 按指定的请求方法查找并执行路由
+    bool dispatch(HttpRequest::Method method, HttpRequest &req, HttpResponse *resp);
+
     std::regex convertToRegex(const std::string &pathPattern)
     { // 将路径模式转换为正则表达式，支持匹配任意路径参数
         std::string regexPattern = "^" + std::regex_replace(pathPattern, std::regex(R"(/:([^/]+))"), R"(/([^/]+))") + "$";
@@ -84,7 +149,7 @@ private:
     }
 
     // 提取路径参数
-    void extractPathParameters(const std::smatch &match, HttpRequest &request)
+    void extractPathParameters(const std::cmatch &match, HttpRequest &request)
     {
         // Assuming the first match is the full path, parameters start from index 1
         for (size_t i = 1; i < match.size(); ++i)
@@ -112,10 +177,19 @@ private:
             : method_(method), pathRegex_(pathRegex), handler_(handler) {}
     };
 
-    std::unordered_map<RouteKey, HandlerPtr, RouteKeyHash>      handlers_;       // 精准匹配
-    std::unordered_map<RouteKey, HandlerCallback, RouteKeyHash> callbacks_; // 精准匹配
+    // 路由树中的动态路由，handler_和callback_二者其一有效
+    struct DynamicRoute
+    {
+        HandlerPtr      handler_;
+        HandlerCallback callback_;
+    };
+
+    RouteMap<HandlerPtr>                                        handlers_;       // 精准匹配
+    RouteMap<HandlerCallback>                                   callbacks_; // 精准匹配
     std::vector<RouteHandlerObj>                                regexHandlers_;     // 正则匹配
     std::vector<RouteCallbackObj>                               regexCallbacks_;   // 正则匹配
+    std::unordered_map<int, RadixTree>                          trees_;    // 请求方法 -> 路由树
+    std::vector<DynamicRoute>                                   dynamicRoutes_; // 路由树中的路由
 };
 
 
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
-#include <chrono>
 
 namespace http
 {
@@ -24,12 +26,26 @@ public:
     bool isExpired() const;
     void refresh(); // 刷新过期时间
 
+    // 过期时间(秒级时间戳)，供存储层的过期清理使用
+    int64_t getExpiryTime() const
+    { return expiryTime_.load(std::memory_order_relaxed); }
+
     void setManager(SessionManager* sessionManager) 
     { sessionManager_ = sessionManager; }
 
     SessionManager* getManager() const 
     { return sessionManager_; }
 
+    // 脏标记: 数据被修改或过期时间推后较多时置位，请求结束时由SessionManager统一写回存储
+    bool isDirty() const
+    { return dirty_.load(std::memory_order_acquire); }
+
+    void markDirty()
+    { dirty_.store(true, std::memory_order_release); }
+
+    // 已写回存储，清除脏标记
+    void markClean();
+
     // 数据存取
     void setValue(const std::string&key, const std::string&value);
     std::string getValue(const std::string&key) const;
@@ -38,7 +54,10 @@ public:
 private:
     std::string                                  sessionId_;
     std::unordered_map<std::string, std::string> data_;
-    std::chrono::system_clock::time_point        expiryTime_;
+    mutable std::mutex                           mutex_; // 同一会话可能被多个线程同时访问
+    std::atomic<int64_t>                         expiryTime_; // 过期时间(秒级时间戳)，清理线程会并发读取
+    std::atomic<int64_t>                         savedExpiryTime_; // 最近一次写回存储时的过期时间
+    std::atomic<bool>                            dirty_; // 是否有未写回存储的修改
     int                                          maxAge_; // 过期时间（秒）
     SessionManager*                              sessionManager_;
 };
@@ -4,6 +4,7 @@
 #include "../http/HttpRequest.h"
 #include "../http/HttpResponse.h"
 #include <memory>
+#include <mutex>
 #include <random>
 
 namespace http
@@ -16,8 +17,11 @@ class SessionManager
 public:
     explicit SessionManager(std::unique_ptr<SessionStorage> storage);
 
-    // 从请求中获取或创建会话
+    // 从请求中获取或创建会话，会话会被记录到当前线程正在处理的请求中
     std::shared_ptr<Session> getSession(const HttpRequest& req, HttpResponse* resp);
+
+    // 请求处理结束时调用，把本次请求中修改过的会话写回存储(每个会话最多写一次)
+    void flushSessions();
     
      // 销毁会话
     void destroySession(const std::string& sessionId);
@@ -25,10 +29,11 @@ public:
     // 清理过期会话
     void cleanExpiredSessions();
 
-    // 更新会话
+    // 立即把会话写回存储
     void updateSession(std::shared_ptr<Session> session)
     {
         storage_->save(session);
+        session->markClean();
     }
 private:
     std::string generateSessionId();
@@ -38,6 +43,7 @@ private:
 private:
     std::unique_ptr<SessionStorage> storage_;
     std::mt19937 rng_; // 用于生成随机会话id
+    std::mutex   rngMutex_; // 多个IO线程会同时创建会话
 };
 
 } // namespace session
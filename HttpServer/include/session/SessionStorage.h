@@ -1,6 +1,9 @@
 #pragma once
 #include "Session.h"
+#include "../utils/TimingWheel.h"
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace http
 {
@@ -14,17 +17,40 @@ public:
     virtual void save(std::shared_ptr<Session> session) = 0;
     virtual std::shared_ptr<Session> load(const std::string& sessionId) = 0;
     virtual void remove(const std::string& sessionId) = 0;
+    // 清理过期会话，由SessionManager定期调用，自带过期机制的存储可以不实现
+    virtual void cleanExpired() {}
 };
 
 // 基于内存的会话存储实现
+// 按会话ID分片加锁，不同IO线程访问不同分片时互不竞争
+// 每个分片有一个时间轮，cleanExpired每次只检查到期槽中的会话，不做全量扫描
 class MemorySessionStorage : public SessionStorage
 {
 public:
+    explicit MemorySessionStorage(size_t numShards = 16);
+
     void save(std::shared_ptr<Session> session) override;
     std::shared_ptr<Session> load(const std::string& sessionId) override;
     void remove(const std::string& sessionId) override;
+    void cleanExpired() override;
+
+    size_t size() const;
+
+private:
+    struct Shard
+    {
+        explicit Shard(int64_t nowSec);
+
+        mutable std::mutex                                        mutex;
+        std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+        TimingWheel<std::string>                                  wheel; // 会话ID按过期时间分槽
+    };
+
+    Shard& shardFor(const std::string& sessionId)
+    { return *shards_[std::hash<std::string>{}(sessionId) & (shards_.size() - 1)]; }
+
 private:
-    std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
+    std::vector<std::unique_ptr<Shard>> shards_; // 分片数为2的幂
 };
 
 } // namespace session
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <muduo/base/noncopyable.h>
+
+#include "../worker/WorkerPool.h"
+
+namespace ssl
+{
+
+// 握手线程池的统计快照
+struct HandshakeStats
+{
+    int64_t  inFlight = 0; // 当前正在进行的握手数
+    uint64_t rejected = 0; // 超过并发握手上限被关闭的连接数
+    uint64_t offloaded = 0; // 在握手线程中执行的握手步骤数
+    size_t   queueSize = 0; // 等待握手线程的步骤数
+    int64_t  avgWaitUs = 0; // 握手步骤的平均排队时间(微秒)
+    int64_t  maxWaitUs = 0; // 握手步骤的最长排队时间(微秒)
+};
+
+// TLS握手的并发上限和执行握手计算的线程池，所有IO线程共享
+// 完整握手的私钥运算(RSA签名、ECDHE)交给握手线程执行，IO线程只负责收发握手消息，
+// 重连风暴时已建立连接的请求不会排在大量握手计算之后
+class HandshakePool : muduo::noncopyable
+{
+public:
+    using Task = std::function<void()>;
+
+    // numThreads为0时握手仍在IO线程中执行，只限制并发数；maxInFlight为0表示不限制并发握手数
+    HandshakePool(int numThreads, size_t maxInFlight);
+
+    void start();
+    void stop();
+
+    // 连接开始握手前占用一个名额，超过上限时返回false，由调用者关闭连接
+    bool tryAcquire();
+    // 握手完成、失败或连接关闭时归还名额
+    void release();
+
+    // 在握手线程中执行一个握手步骤，未启用握手线程或排队的步骤已满时返回false，由调用者在IO线程中执行
+    bool submit(Task task);
+    bool offloading() const
+    { return pool_.started(); }
+
+    // 握手步骤开始执行时由握手线程调用
+    void recordWait(int64_t waitUs);
+    HandshakeStats stats() const;
+
+private:
+    http::worker::WorkerPool pool_; // 握手线程
+    int                      numThreads_; // 握手线程数
+    size_t                   maxInFlight_; // 并发握手上限
+    std::atomic<int64_t>     inFlight_{0}; // 当前正在进行的握手数
+    std::atomic<uint64_t>    rejected_{0}; // 超过上限被拒绝的连接数
+    std::atomic<uint64_t>    offloaded_{0}; // 在握手线程中执行的步骤数
+    std::atomic<int64_t>     totalWaitUs_{0}; // 累计排队时间(微秒)
+    std::atomic<int64_t>     maxWaitUs_{0}; // 最长排队时间(微秒)
+};
+
+} // namespace ssl
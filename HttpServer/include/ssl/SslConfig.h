@@ -16,6 +16,8 @@ public:
     void setCertificateFile(const std::string& certFile) { certFile_ = certFile; }
     void setPrivateKeyFile(const std::string& keyFile) { keyFile_ = keyFile; }
     void setCertificateChainFile(const std::string& chainFile) { chainFile_ = chainFile; }
+    // 这个证书服务的域名(SNI)，支持 *.example.com，只用于默认证书之外的证书
+    void addServerName(const std::string& name) { serverNames_.push_back(name); }
     
     // 协议版本和加密套件配置
     void setProtocolVersion(SSLVersion version) { version_ = version; }
@@ -29,27 +31,46 @@ public:
     void setSessionTimeout(int seconds) { sessionTimeout_ = seconds; }
     void setSessionCacheSize(long size) { sessionCacheSize_ = size; }
 
+    // 无状态会话票据配置
+    // 密钥文件为空时在进程内生成密钥并按轮换间隔更换；否则按轮换间隔重新加载文件
+    // 密钥由所有证书共享，密钥文件和轮换间隔取默认证书的配置；是否签发票据和票据有效期按各证书自己的配置
+    // 票据有效期与会话缓存超时相互独立，TLS 1.2的票据同时受会话缓存超时限制
+    void setSessionTickets(bool enable) { sessionTickets_ = enable; }
+    void setTicketKeyFile(const std::string& keyFile) { ticketKeyFile_ = keyFile; }
+    void setTicketLifetime(int seconds) { ticketLifetime_ = seconds; }
+    void setTicketRotationInterval(int seconds) { ticketRotationInterval_ = seconds; }
+
     // Getters
     const std::string& getCertificateFile() const { return certFile_; }
     const std::string& getPrivateKeyFile() const { return keyFile_; }
     const std::string& getCertificateChainFile() const { return chainFile_; }
+    const std::vector<std::string>& getServerNames() const { return serverNames_; }
     SSLVersion getProtocolVersion() const { return version_; }
     const std::string& getCipherList() const { return cipherList_; }
     bool getVerifyClient() const { return verifyClient_; }
     int getVerifyDepth() const { return verifyDepth_; }
     int getSessionTimeout() const { return sessionTimeout_; }
     long getSessionCacheSize() const { return sessionCacheSize_; }
+    bool getSessionTickets() const { return sessionTickets_; }
+    const std::string& getTicketKeyFile() const { return ticketKeyFile_; }
+    int getTicketLifetime() const { return ticketLifetime_; }
+    int getTicketRotationInterval() const { return ticketRotationInterval_; }
 
 private:
     std::string certFile_; // 证书文件
     std::string keyFile_; // 私钥文件
     std::string chainFile_; // 证书链文件
+    std::vector<std::string> serverNames_; // 证书对应的域名
     SSLVersion  version_; // 协议版本
     std::string cipherList_; // 加密套件
     bool        verifyClient_; // 是否验证客户端
     int         verifyDepth_; // 验证深度
     int         sessionTimeout_; // 会话超时时间
     long        sessionCacheSize_; // 会话缓存大小
+    bool        sessionTickets_; // 是否签发无状态会话票据
+    std::string ticketKeyFile_; // 票据密钥文件
+    int         ticketLifetime_; // 票据有效期(秒)
+    int         ticketRotationInterval_; // 票据密钥轮换间隔(秒)
 };
 
 } // namespace ssl
\ No newline at end of file
@@ -1,30 +1,52 @@
 #pragma once
+#include "HandshakePool.h"
 #include "SslContext.h"
 #include <muduo/net/TcpConnection.h>
 #include <muduo/net/Buffer.h>
 #include <muduo/base/noncopyable.h>
 #include <openssl/ssl.h>
+#include <functional>
 #include <memory>
+#include <string>
 
-namespace ssl 
+namespace ssl
 {
 
-// 添加消息回调函数类型定义
-using MessageCallback = std::function<void(const std::shared_ptr<muduo::net::TcpConnection>&,
-                                         muduo::net::Buffer*,
-                                         muduo::Timestamp)>;
-
-class SslConnection : muduo::noncopyable 
+// 一个TLS连接的记录层引擎，只在连接所属的IO线程中使用
+// 读: 每次读事件把收到的密文全部交给SSL，解密出所有完整的记录追加到解密缓冲区
+// 写: 明文先追加到待加密缓冲区，本轮事件循环结束时统一用一次SSL_write加密，
+//     加密结果一次交给TcpConnection，一次读事件中的多个响应只产生一次系统调用
+// 握手: 启用握手线程时，每一步SSL_do_handshake交给HandshakePool执行，SSL对象同一时间只属于一个线程，
+//     步骤执行期间收到的密文暂存在readBuffer_中，步骤完成后握手消息和后续处理都回到连接所属的IO线程
+// 加密始终在用户态完成: muduo的TcpConnection不暴露socket fd，输出也必须经过它的输出缓冲区，
+//     无法把SSL切换到socket BIO启用内核TLS(kTLS)，TLS连接上的文件响应同样读入内存加密后发送
+class SslConnection : muduo::noncopyable
 {
 public:
     using TcpConnectionPtr = std::shared_ptr<muduo::net::TcpConnection>;
     using BufferPtr = muduo::net::Buffer*;
-    
-    SslConnection(const TcpConnectionPtr& conn, SslContext* ctx);
+    // 在握手线程中完成握手后，在IO线程中调用，处理握手期间已经收到的请求
+    using HandshakeCallback = std::function<void (const TcpConnectionPtr&)>;
+
+    // SslConnection随连接状态挂在conn上，生命周期不超过conn，因此只保存裸指针
+    // pool不为空时调用者已经为这个连接占用了一个握手名额，握手结束或连接关闭时归还，
+    // 连接关闭时仍有步骤在握手线程中执行的，等这个步骤返回后再归还
+    // 服务器关闭时连接可能晚于服务器的其他成员销毁，因此共同持有pool
+    SslConnection(const TcpConnectionPtr& conn, SslContext* ctx,
+                  const std::shared_ptr<HandshakePool>& pool = nullptr);
     ~SslConnection();
 
     void startHandshake();
+    void setHandshakeCallback(const HandshakeCallback& cb)
+    { handshakeCallback_ = cb; }
+    // 发送明文，握手完成前的数据会在握手完成后发出
     void send(const void* data, size_t len);
+    // 待加密的数据发送完后发出close_notify并关闭写端
+    void shutdown();
+    // 立即加密并发送所有待发送的明文
+    void flush();
+    // 尚未加密发送的明文字节数
+    size_t pendingBytes() const { return writeBuffer_.readableBytes(); }
     void onRead(const TcpConnectionPtr& conn, BufferPtr buf, muduo::Timestamp time);
     bool isHandshakeCompleted() const { return state_ == SSLState::ESTABLISHED; }
     muduo::net::Buffer* getDecryptedBuffer() { return &decryptedBuffer_; }
@@ -32,26 +54,40 @@ public:
     static int bioWrite(BIO* bio, const char* data, int len);
     static int bioRead(BIO* bio, char* data, int len);
     static long bioCtrl(BIO* bio, int cmd, long num, void* ptr);
-    // 设置消息回调函数
-    void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
 private:
     void handleHandshake();
-    void onEncrypted(const char* data, size_t len);
-    void onDecrypted(const char* data, size_t len);
+    // 把一步握手交给握手线程，线程池已停止时返回false
+    bool offloadHandshake();
+    // 握手线程执行完一步后在IO线程中调用，output为要发给对端的握手消息
+    void onHandshakeStep(int ret, const std::string& output, const std::string& error);
+    void handshakeCompleted();
+    void handshakeFailed(const char* error);
+    void releaseHandshakeSlot();
+    // 解密readBio_中所有完整的记录
+    void readRecords();
+    // 把writeBio_中的密文(握手消息、加密后的数据、告警)一次交给连接
+    void flushWriteBio();
+    // 本轮事件循环结束时调用flush，重复调用只登记一次
+    void queueFlush();
     SSLError getLastError(int ret);
     void handleError(SSLError error);
 
 private:
-    SSL*                ssl_; // SSL 连接
-    SslContext*         ctx_; // SSL 上下文
-    TcpConnectionPtr    conn_; // TCP 连接
-    SSLState            state_; // SSL 状态
-    BIO*                readBio_;   // 网络数据 -> SSL
-    BIO*                writeBio_;  // SSL -> 网络数据
-    muduo::net::Buffer  readBuffer_; // 读缓冲区
-    muduo::net::Buffer  writeBuffer_; // 写缓冲区
-    muduo::net::Buffer  decryptedBuffer_; // 解密后的数据
-    MessageCallback     messageCallback_; // 消息回调
+    std::shared_ptr<SSL>       ssl_; // SSL 连接，握手线程中的步骤执行期间也持有它
+    SslContext*                ctx_; // SSL 上下文
+    muduo::net::TcpConnection* conn_; // TCP 连接
+    SSLState                   state_; // SSL 状态
+    BIO*                       readBio_;   // 网络数据 -> SSL
+    BIO*                       writeBio_;  // SSL -> 网络数据
+    muduo::net::Buffer         readBuffer_; // 握手步骤在握手线程中执行期间收到的密文
+    muduo::net::Buffer         writeBuffer_; // 待加密的明文
+    muduo::net::Buffer         decryptedBuffer_; // 解密后的数据
+    bool                       flushQueued_; // 是否已登记本轮事件循环的flush
+    bool                       shutdownRequested_; // 待发送数据发完后关闭写端
+    std::shared_ptr<HandshakePool> pool_; // 握手并发上限和握手线程，为空时不限制
+    std::shared_ptr<HandshakePool> handshakeSlot_; // 占用的握手名额，指向pool_，最后一个引用释放时归还
+    bool                       handshakeRunning_; // 是否有握手步骤正在握手线程中执行
+    HandshakeCallback          handshakeCallback_; // 在握手线程中完成握手后调用
 };
 
-} // namespace ssl
\ No newline at end of file
+} // namespace ssl
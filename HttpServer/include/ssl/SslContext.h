@@ -1,30 +1,102 @@
 #pragma once
 #include "SslConfig.h"
+#include "TicketKeyRing.h"
 #include <openssl/ssl.h>
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 #include <muduo/base/noncopyable.h>
 
-namespace ssl 
+namespace ssl
 {
 
-class SslContext : muduo::noncopyable 
+// 握手统计
+struct SslStats
+{
+    uint64_t fullHandshakes = 0; // 完整握手次数
+    uint64_t resumedHandshakes = 0; // 通过会话缓存或票据恢复的握手次数
+    uint64_t reloads = 0; // 证书重新加载成功的次数
+};
+
+// 服务器的所有证书
+// 第一个SslConfig为默认证书，其余按 SslConfig::addServerName 登记的名称在握手时根据SNI选择
+// 证书重新加载时整体创建一组新的SSL_CTX再替换，新连接使用新证书，已建立的连接继续持有原来的SSL_CTX
+class SslContext : muduo::noncopyable
 {
 public:
     explicit SslContext(const SslConfig& config);
     ~SslContext();
 
+    // 添加一个按SNI选择的证书，已经initialize时立即重新创建所有SSL_CTX，证书无效时返回false
+    bool addConfig(const SslConfig& config);
+
     bool initialize();
-    SSL_CTX* getNativeHandle() { return ctx_; }
+
+    // 重新读取所有证书文件并整体替换，失败时继续使用原来的证书
+    // 可以在任意线程调用，重复调用会串行执行
+    bool reload();
+    // 证书、私钥或证书链文件自上次加载后是否有修改
+    bool certificatesChanged() const;
+
+    // 用当前的默认证书为新连接创建SSL对象，握手时再根据SNI切换
+    SSL* newSsl();
+    // 当前的默认证书的SSL_CTX，重新加载后会变化，不要长期保存
+    SSL_CTX* getNativeHandle() const;
+
+    // 轮换会话票据密钥，由服务器按配置的间隔调用，未启用票据时无效果
+    void rotateTicketKeys();
+    int ticketRotationInterval() const { return configs_.front().getTicketRotationInterval(); }
+    bool sessionTicketsEnabled() const { return ticketKeys_ != nullptr; }
+
+    // 握手完成时由SslConnection调用
+    void recordHandshake(bool resumed)
+    { ++(resumed ? resumedHandshakes_ : fullHandshakes_); }
+    SslStats stats() const;
 
 private:
-    bool loadCertificates();
-    bool setupProtocol();
-    void setupSessionCache();
+    // 一次加载得到的所有SSL_CTX，创建后只读
+    struct CertificateSet : muduo::noncopyable
+    {
+        ~CertificateSet();
+        // 按服务器名查找证书，支持 *.example.com 形式的通配符，找不到时返回nullptr
+        SSL_CTX* find(const std::string& serverName) const;
+
+        std::vector<SSL_CTX*>                         contexts; // 与configs_一一对应，第一个为默认证书
+        std::vector<std::pair<std::string, SSL_CTX*>> names; // 小写的服务器名 -> SSL_CTX
+    };
+    using CertificateSetPtr = std::shared_ptr<const CertificateSet>;
+    // 证书文件路径 -> 修改时间
+    using FileTimes = std::vector<std::pair<std::string, time_t>>;
+
+    // 读取所有证书并替换当前证书
+    bool rebuild();
+    CertificateSetPtr loadCertificateSet();
+    SSL_CTX* createContext(const SslConfig& config);
+    bool loadCertificates(SSL_CTX* ctx, const SslConfig& config);
+    bool setupProtocol(SSL_CTX* ctx, const SslConfig& config);
+    void setupSessionCache(SSL_CTX* ctx, const SslConfig& config);
+    void setupSessionTickets(SSL_CTX* ctx, const SslConfig& config);
+    FileTimes certificateFileTimes() const;
+    CertificateSetPtr certificates() const;
+    // ClientHello中的SNI到达时切换到对应证书的SSL_CTX
+    static int serverNameCallback(SSL* ssl, int* alert, void* arg);
     static void handleSslError(const char* msg);
 
 private:
-    SSL_CTX*  ctx_; // SSL上下文
-    SslConfig config_; // SSL配置
+    std::vector<SslConfig>         configs_; // 第一个为默认证书，会话票据按它的配置
+    mutable std::mutex             mutex_; // 保护certificates_，读取时只拷贝shared_ptr
+    CertificateSetPtr              certificates_; // 当前使用的证书
+    mutable std::mutex             reloadMutex_; // 串行化重新加载，保护fileTimes_
+    FileTimes                      fileTimes_; // 上次加载时证书文件的修改时间
+    std::unique_ptr<TicketKeyRing> ticketKeys_; // 会话票据密钥，所有SSL_CTX共享，未启用票据时为空
+    std::atomic<uint64_t>          fullHandshakes_{0}; // 完整握手次数
+    std::atomic<uint64_t>          resumedHandshakes_{0}; // 恢复会话的握手次数
+    std::atomic<uint64_t>          reloads_{0}; // 证书重新加载成功的次数
 };
 
-} // namespace ssl
\ No newline at end of file
+} // namespace ssl
@@ -0,0 +1,74 @@
+#pragma once
+#include <openssl/ssl.h>
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+#include <openssl/hmac.h>
+#endif
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <muduo/base/noncopyable.h>
+
+namespace ssl
+{
+
+// 无状态会话票据的密钥环，所有IO线程共享
+// 第一个密钥用于加密新票据，其余密钥只用于解密之前签发、仍在有效期内的票据
+// 未配置密钥文件时在进程内随机生成并定期轮换；配置了密钥文件时每次轮换重新加载文件，
+// 由外部统一更新文件，多个进程/机器签发的票据可以互相恢复
+class TicketKeyRing : muduo::noncopyable
+{
+public:
+    // 密钥文件由若干个80字节的密钥组成: 16字节名称 + 32字节HMAC密钥 + 32字节AES密钥，第一个为当前密钥
+    static const size_t kKeyFileEntrySize = 80;
+
+    // lifetime为退役的密钥继续保留的时间(秒)，以便解密它签发、仍在有效期内的票据
+    TicketKeyRing(const std::string& keyFile, int lifetime);
+
+    // 生成或加载第一组密钥，密钥文件无效时返回false
+    bool initialize();
+    // 轮换密钥，由定时器调用
+    void rotate();
+    // 注册为SSL_CTX的票据密钥回调，lifetime为这个SSL_CTX签发的票据的有效期(秒)
+    // 票据有效期与SSL_CTX_set_timeout设置的会话缓存超时相互独立
+    void install(SSL_CTX* ctx, int lifetime);
+
+private:
+    struct Key
+    {
+        unsigned char name[16];
+        unsigned char hmacKey[32];
+        unsigned char aesKey[32];
+        time_t        expire; // 0表示当前密钥，否则为退役后可继续解密的截止时间
+    };
+
+    bool loadKeyFile(std::vector<Key>* keys) const;
+    bool generateKey(Key* key) const;
+    // 加密时返回当前密钥，解密时按名称查找，找不到返回false
+    bool findKey(const unsigned char* name, bool encrypt, Key* key, bool* current);
+
+    // 签发票据前调用，TLS 1.3的票据会话不进入会话缓存，有效期直接改为票据有效期
+    static int generateTicketCallback(SSL* ssl, void* arg);
+    // 解密票据后调用，超过票据有效期的票据改为完整握手并签发新票据
+    static SSL_TICKET_RETURN decryptTicketCallback(SSL* ssl, SSL_SESSION* session,
+                                                   const unsigned char* keyName, size_t keyNameLength,
+                                                   SSL_TICKET_STATUS status, void* arg);
+    // 握手当前使用的SSL_CTX的票据有效期
+    static int lifetimeOf(SSL* ssl);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static int ticketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv,
+                                 EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc);
+#else
+    static int ticketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv,
+                                 EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* macCtx, int enc);
+#endif
+
+private:
+    std::string      keyFile_; // 密钥文件，为空时在进程内生成密钥
+    int              lifetime_; // 退役密钥的保留时间(秒)
+    std::mutex       mutex_; // 保护keys_，轮换在主线程，查找在IO线程
+    std::vector<Key> keys_; // 第一个为当前密钥
+};
+
+} // namespace ssl
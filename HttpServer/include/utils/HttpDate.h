@@ -0,0 +1,94 @@
+#pragma once
+
+#include <ctime>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace http
+{
+
+// 格式化为 RFC 7231 规定的 IMF-fixdate，如 "Sun, 06 Nov 1994 08:49:37 GMT"
+inline std::string formatHttpDate(time_t t)
+{
+    struct tm tm;
+    ::gmtime_r(&t, &tm);
+    char buf[32];
+    size_t n = ::strftime(buf, sizeof buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buf, n);
+}
+
+// 解析 IMF-fixdate，格式不合法时返回-1
+// 已废弃的 RFC 850 和 asctime 格式不再被现代浏览器发送，不做支持
+inline time_t parseHttpDate(std::string_view str)
+{
+    // strptime需要以'\0'结尾的字符串，日期长度固定为29字节
+    char buf[32];
+    if (str.size() >= sizeof buf)
+    {
+        return -1;
+    }
+    ::memcpy(buf, str.data(), str.size());
+    buf[str.size()] = '\0';
+
+    struct tm tm = {};
+    const char* end = ::strptime(buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (end == nullptr || *end != '\0')
+    {
+        return -1;
+    }
+    return ::timegm(&tm);
+}
+
+// 每个线程缓存一份 "Date: <IMF-fixdate>\r\n"，序列化响应时直接拷贝，不再格式化时间
+// IO线程由本线程EventLoop的定时器每秒刷新一次，其他线程在秒数变化时按需刷新
+class DateCache
+{
+public:
+    // 由定时器调用，之后当前线程不再按需检查时间
+    static void refresh()
+    {
+        Cache& cache = local();
+        cache.timerDriven = true;
+        update(cache, ::time(nullptr));
+    }
+
+    static std::string_view header()
+    {
+        Cache& cache = local();
+        if (!cache.timerDriven)
+        {
+            time_t now = ::time(nullptr);
+            if (now != cache.second)
+            {
+                update(cache, now);
+            }
+        }
+        return std::string_view(cache.buf, cache.len);
+    }
+
+private:
+    struct Cache
+    {
+        char   buf[48];
+        size_t len = 0;
+        time_t second = -1;
+        bool   timerDriven = false;
+    };
+
+    static Cache& local()
+    {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    static void update(Cache& cache, time_t now)
+    {
+        struct tm tm;
+        ::gmtime_r(&now, &tm);
+        cache.len = ::strftime(cache.buf, sizeof cache.buf, "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+        cache.second = now;
+    }
+};
+
+} // namespace http
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Channel.h>
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+// 静态资源缓存: 启动时把目录下的文件全部读入内存，之后通过inotify监听文件变化并重新加载
+// 缓存中的资源不可变，响应通过shared_ptr引用文件内容，每个请求不再读盘也不再拷贝
+class StaticFileCache : muduo::noncopyable
+{
+public:
+    // 一个已加载的文件，加载完成后不再修改，可以被多个线程同时读取
+    struct Asset
+    {
+        std::string                        name; // 相对于根目录的文件名
+        std::shared_ptr<const std::string> content; // 文件内容
+        std::string                        contentType; // 根据扩展名推断的 Content-Type
+        std::string                        etag; // 加载时由内容哈希计算出的强ETag(带引号)
+        time_t                             lastModified; // 文件修改时间
+    };
+    using AssetPtr = std::shared_ptr<const Asset>;
+
+    explicit StaticFileCache(const std::string& rootDir);
+    ~StaticFileCache();
+
+    // 加载根目录下的全部普通文件，返回加载的文件数，目录不存在时返回-1
+    int load();
+
+    // 在loop中监听根目录的文件变化，必须在loop所在线程调用
+    void watch(muduo::net::EventLoop* loop);
+
+    // 获取文件，不存在时返回nullptr，可在任意线程调用
+    AssetPtr get(const std::string& name) const;
+
+    static std::string contentTypeOf(const std::string& name);
+
+    // 由文件内容计算强ETag，内容相同ETag就相同，与修改时间无关
+    static std::string etagOf(const std::string& content);
+
+private:
+    void reload(const std::string& name);
+    void handleInotify();
+
+private:
+    std::string                               rootDir_;
+    mutable std::mutex                        mutex_; // 保护assets_，IO线程读，监听线程替换
+    std::unordered_map<std::string, AssetPtr> assets_; // 文件名 -> 资源
+    int                                       inotifyFd_;
+    std::unique_ptr<muduo::net::Channel>      inotifyChannel_;
+};
+
+} // namespace http
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace http
+{
+
+// 按秒划分槽位的时间轮，Key按到期时间放入对应的槽中
+// 每次advance只检查走过的槽，不需要遍历全部Key，实现增量过期清理
+// 非线程安全，由调用方加锁
+template <typename Key>
+class TimingWheel
+{
+public:
+    TimingWheel(size_t numSlots, int64_t nowSec)
+        : buckets_(numSlots)
+        , lastTick_(nowSec)
+    {}
+
+    // 登记一个在expireSec秒到期的Key
+    void add(const Key& key, int64_t expireSec)
+    {
+        if (expireSec <= lastTick_)
+        {
+            expireSec = lastTick_ + 1; // 已经过期的放到下一格，保证一定会被检查
+        }
+        buckets_[expireSec % buckets_.size()].push_back(key);
+    }
+
+    // 推进到nowSec，对走过的槽中的每个Key调用check(key)
+    // check返回Key新的到期时间(秒)，Key仍未到期时会被重新登记；返回0表示已移除
+    template <typename Check>
+    void advance(int64_t nowSec, Check&& check)
+    {
+        int64_t from = lastTick_ + 1;
+        // 落后超过一圈时每个槽只需检查一次
+        if (nowSec - lastTick_ > static_cast<int64_t>(buckets_.size()))
+        {
+            from = nowSec - static_cast<int64_t>(buckets_.size()) + 1;
+        }
+        lastTick_ = nowSec;
+
+        std::vector<Key> expired;
+        for (int64_t tick = from; tick <= nowSec; ++tick)
+        {
+            expired.clear();
+            expired.swap(buckets_[tick % buckets_.size()]);
+            for (const Key& key : expired)
+            {
+                int64_t expireSec = check(key);
+                if (expireSec > 0)
+                {
+                    add(key, expireSec);
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<std::vector<Key>> buckets_;
+    int64_t                       lastTick_; // 最后一次推进到的时间(秒)
+};
+
+} // namespace http
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+
+namespace http
+{
+namespace worker
+{
+
+// 有界工作线程池，用于执行会阻塞的路由处理器(数据库查询、AI计算等)
+// 与 muduo::ThreadPool 不同，队列满时trySubmit直接返回false，而不是阻塞提交任务的IO线程
+class WorkerPool : muduo::noncopyable
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkerPool(const std::string& name = "WorkerPool");
+    ~WorkerPool();
+
+    // 必须在start之前设置，0表示不限制队列长度
+    void setMaxQueueSize(size_t maxSize)
+    { maxQueueSize_ = maxSize; }
+
+    void start(int numThreads);
+    void stop();
+
+    // 提交任务，队列已满或线程池未启动时返回false
+    bool trySubmit(Task task);
+
+    size_t queueSize() const;
+
+    bool started() const
+    { return !threads_.empty(); }
+
+private:
+    void runInThread();
+
+private:
+    std::string              name_;
+    mutable std::mutex       mutex_;
+    std::condition_variable  notEmpty_;
+    std::deque<Task>         queue_; // 待执行的任务
+    std::vector<std::thread> threads_; // 工作线程
+    size_t                   maxQueueSize_; // 队列最大长度
+    bool                     running_;
+};
+
+// 阻塞路由的排队统计，IO线程和工作线程会并发更新
+struct RouteStats
+{
+    std::atomic<int64_t>  queued { 0 }; // 当前在队列中等待的请求数
+    std::atomic<uint64_t> completed { 0 }; // 已执行完成的请求数
+    std::atomic<uint64_t> rejected { 0 }; // 因队列已满被拒绝的请求数
+    std::atomic<int64_t>  totalWaitUs { 0 }; // 累计排队等待时间(微秒)
+    std::atomic<int64_t>  maxWaitUs { 0 }; // 最长排队等待时间(微秒)
+
+    void recordWait(int64_t waitUs)
+    {
+        totalWaitUs += waitUs;
+        int64_t prev = maxWaitUs.load();
+        while (waitUs > prev && !maxWaitUs.compare_exchange_weak(prev, waitUs))
+        {
+        }
+    }
+};
+
+} // namespace worker
+} // namespace http
@@ -0,0 +1,177 @@
+#include "../../include/http/ConnectionTimer.h"
+#include "../../include/http/ConnectionState.h"
+#include "../../include/http/HttpResponse.h"
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+namespace
+{
+
+const size_t kWheelSlots = 64; // 时间轮的槽数，更远的截止时间会被提前检查一次再重新登记
+const double kCloseDelay = 1.0; // 返回408后等待对端读取响应的时间(秒)，之后强制关闭
+
+} // namespace
+
+ConnectionTimer::ConnectionTimer(const TimeoutOptions& options, TimeoutStats* stats)
+    : options_(options)
+    , stats_(stats)
+    , recheckInterval_(0)
+    , wheel_(kWheelSlots, muduo::Timestamp::now().secondsSinceEpoch())
+{
+    // 当前没有超时限制的连接(如正在处理请求)按最短的超时时间定期重新检查
+    for (int timeout : { options_.idleTimeout, options_.headerTimeout, options_.requestTimeout })
+    {
+        if (timeout > 0 && (recheckInterval_ == 0 || timeout < recheckInterval_))
+        {
+            recheckInterval_ = timeout;
+        }
+    }
+    if (recheckInterval_ == 0)
+    {
+        recheckInterval_ = static_cast<int>(kWheelSlots);
+    }
+}
+
+void ConnectionTimer::add(const muduo::net::TcpConnectionPtr& conn)
+{
+    ConnectionState* state = ConnectionState::get(conn);
+    if (!state)
+    {
+        return;
+    }
+    Reason reason;
+    int64_t expireSec = deadline(conn, state, &reason);
+    if (expireSec == 0)
+    {
+        expireSec = muduo::Timestamp::now().secondsSinceEpoch() + recheckInterval_;
+    }
+    wheel_.add(conn, expireSec);
+}
+
+void ConnectionTimer::tick()
+{
+    int64_t nowSec = muduo::Timestamp::now().secondsSinceEpoch();
+    wheel_.advance(nowSec, [this, nowSec](const std::weak_ptr<muduo::net::TcpConnection>& weakConn) {
+        return check(weakConn, nowSec);
+    });
+}
+
+int64_t ConnectionTimer::check(const std::weak_ptr<muduo::net::TcpConnection>& weakConn, int64_t nowSec)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || !conn->connected())
+    {
+        return 0;
+    }
+    ConnectionState* state = ConnectionState::get(conn);
+    if (!state)
+    {
+        return 0;
+    }
+
+    // 输出缓冲区只在排空时通知，部分写入没有回调；待发送字节数与上次检查时不同说明对端仍在读取或有新的响应数据
+    size_t pending = state->pendingOutput(conn);
+    if (pending > 0 && pending != state->checkedOutput())
+    {
+        state->stats().lastActiveTime = muduo::Timestamp::now();
+    }
+    state->setCheckedOutput(pending);
+
+    Reason reason;
+    int64_t expireSec = deadline(conn, state, &reason);
+    if (expireSec == 0)
+    {
+        return nowSec + recheckInterval_;
+    }
+    if (expireSec > nowSec)
+    {
+        return expireSec; // 期间有过活动，按新的截止时间重新登记
+    }
+    expire(conn, state, reason);
+    return 0;
+}
+
+int64_t ConnectionTimer::deadline(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state, Reason* reason) const
+{
+    // 请求已交给工作线程，由请求处理流程自己负责
+    if (state->requestInFlight())
+    {
+        return 0;
+    }
+
+    // 正在发送响应或等待输出缓冲区排空，对端在空闲超时内没有读走任何数据就关闭连接
+    if (!state->readyForRequest() || state->readPaused())
+    {
+        if (state->responseStream() && state->pendingOutput(conn) == 0)
+        {
+            return 0; // 数据都已发出，等待应用推送下一段
+        }
+        *reason = kIdle;
+        return options_.idleTimeout > 0
+            ? state->stats().lastActiveTime.secondsSinceEpoch() + options_.idleTimeout : 0;
+    }
+
+    muduo::Timestamp start = state->requestStartTime();
+    if (!start.valid())
+    {
+        // 两个请求之间的空闲，每次收发数据都会推迟
+        *reason = kIdle;
+        return options_.idleTimeout > 0
+            ? state->stats().lastActiveTime.secondsSinceEpoch() + options_.idleTimeout : 0;
+    }
+
+    // 请求接收中，截止时间从请求开始时计算，慢速发送的数据不能推迟它
+    int64_t startSec = start.secondsSinceEpoch();
+    int64_t expireSec = 0;
+    if (options_.requestTimeout > 0)
+    {
+        *reason = kRequest;
+        expireSec = startSec + options_.requestTimeout;
+    }
+    if (options_.headerTimeout > 0 && state->context()->expectingHeaders())
+    {
+        int64_t headerExpireSec = startSec + options_.headerTimeout;
+        if (expireSec == 0 || headerExpireSec < expireSec)
+        {
+            *reason = kHeader;
+            expireSec = headerExpireSec;
+        }
+    }
+    return expireSec;
+}
+
+void ConnectionTimer::expire(const muduo::net::TcpConnectionPtr& conn, ConnectionState* state, Reason reason)
+{
+    if (reason == kIdle)
+    {
+        ++stats_->idle;
+        LOG_DEBUG << "Idle timeout, close " << conn->name();
+        conn->forceClose();
+        return;
+    }
+
+    ++(reason == kHeader ? stats_->header : stats_->request);
+    LOG_WARN << (reason == kHeader ? "Header" : "Request") << " timeout, close " << conn->name()
+             << " from " << conn->peerAddress().toIpPort();
+    if (state->sslConnection() && !state->sslConnection()->isHandshakeCompleted())
+    {
+        conn->forceClose(); // 握手未完成，无法发送响应
+        return;
+    }
+
+    // 告知客户端请求超时，之后不再等待它关闭连接
+    HttpResponse response(true);
+    response.setStatusLine("HTTP/1.1", HttpResponse::k408RequestTimeout,
+                           HttpResponse::reasonPhrase(HttpResponse::k408RequestTimeout));
+    response.setContentLength(0);
+    muduo::net::Buffer buf;
+    response.appendToBuffer(&buf);
+    state->send(conn, buf.peek(), buf.readableBytes());
+    state->shutdown(conn);
+    conn->forceCloseWithDelay(kCloseDelay);
+}
+
+} // namespace http
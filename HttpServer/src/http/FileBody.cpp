@@ -0,0 +1,252 @@
+#include "../../include/http/FileBody.h"
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+namespace
+{
+
+const size_t kMaxRanges = 16; // 超过这个数量的多段请求按整个文件响应，避免被用来放大流量
+
+// 解析非负整数，str为空或含非数字字符时返回false
+bool parseOffset(std::string_view str, off_t* value)
+{
+    if (str.empty() || str.size() > 18)
+    {
+        return false;
+    }
+    off_t result = 0;
+    for (char c : str)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    *value = result;
+    return true;
+}
+
+std::string_view trim(std::string_view str)
+{
+    size_t begin = str.find_first_not_of(" \t");
+    if (begin == std::string_view::npos)
+    {
+        return std::string_view();
+    }
+    size_t end = str.find_last_not_of(" \t");
+    return str.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+std::shared_ptr<FileBody> FileBody::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    return std::shared_ptr<FileBody>(new FileBody(path, fd, st.st_size, st.st_mtime));
+}
+
+FileBody::FileBody(const std::string& path, int fd, off_t size, time_t lastModified)
+    : path_(path)
+    , fd_(fd)
+    , size_(size)
+    , lastModified_(lastModified)
+{
+}
+
+FileBody::~FileBody()
+{
+    ::close(fd_);
+}
+
+ssize_t FileBody::read(off_t offset, char* buf, size_t len) const
+{
+    ssize_t n;
+    do
+    {
+        n = ::pread(fd_, buf, len, offset);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+FileBody::RangeResult FileBody::parseRange(std::string_view header, off_t fileSize, std::vector<ByteRange>* ranges)
+{
+    static const char kUnit[] = "bytes=";
+    ranges->clear();
+    if (header.size() <= sizeof(kUnit) - 1 || ::strncasecmp(header.data(), kUnit, sizeof(kUnit) - 1) != 0)
+    {
+        return kNoRange;
+    }
+
+    size_t count = 0;
+    size_t pos = sizeof(kUnit) - 1;
+    while (pos <= header.size())
+    {
+        size_t comma = header.find(',', pos);
+        if (comma == std::string_view::npos)
+        {
+            comma = header.size();
+        }
+        std::string_view spec = trim(header.substr(pos, comma - pos));
+        pos = comma + 1;
+        if (spec.empty())
+        {
+            continue; // 允许 "bytes=0-1, ,5-6" 这样的空项
+        }
+        if (++count > kMaxRanges)
+        {
+            ranges->clear();
+            return kNoRange;
+        }
+
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos)
+        {
+            ranges->clear();
+            return kNoRange;
+        }
+        std::string_view firstStr = spec.substr(0, dash);
+        std::string_view lastStr = spec.substr(dash + 1);
+        off_t first = 0;
+        off_t last = 0;
+
+        if (firstStr.empty())
+        {
+            // "-n": 最后n个字节
+            if (!parseOffset(lastStr, &last))
+            {
+                ranges->clear();
+                return kNoRange;
+            }
+            if (last == 0 || fileSize == 0)
+            {
+                continue; // 不可满足
+            }
+            ranges->emplace_back(std::max<off_t>(0, fileSize - last), fileSize - 1);
+            continue;
+        }
+
+        if (!parseOffset(firstStr, &first))
+        {
+            ranges->clear();
+            return kNoRange;
+        }
+        if (lastStr.empty())
+        {
+            last = fileSize - 1; // "n-": 从n到文件末尾
+        }
+        else if (!parseOffset(lastStr, &last) || last < first)
+        {
+            ranges->clear();
+            return kNoRange;
+        }
+
+        if (first >= fileSize)
+        {
+            continue; // 不可满足
+        }
+        ranges->emplace_back(first, std::min(last, fileSize - 1));
+    }
+
+    if (count == 0)
+    {
+        return kNoRange;
+    }
+    if (ranges->empty())
+    {
+        return kUnsatisfiable;
+    }
+
+    // 合并重叠或相邻的区间，重复请求同一段内容不能放大响应
+    std::sort(ranges->begin(), ranges->end());
+    size_t merged = 0;
+    for (size_t i = 1; i < ranges->size(); ++i)
+    {
+        ByteRange& current = (*ranges)[merged];
+        const ByteRange& next = (*ranges)[i];
+        if (next.first <= current.second + 1)
+        {
+            current.second = std::max(current.second, next.second);
+        }
+        else
+        {
+            (*ranges)[++merged] = next;
+        }
+    }
+    ranges->resize(merged + 1);
+    return kSatisfiable;
+}
+
+size_t FileTransfer::totalBytes() const
+{
+    size_t total = 0;
+    for (const Segment& segment : segments_)
+    {
+        total += segment.prefix.size() + segment.length;
+    }
+    return total;
+}
+
+ssize_t FileTransfer::fill(muduo::net::Buffer* buf, size_t maxBytes)
+{
+    size_t filled = 0;
+    while (!segments_.empty() && filled < maxBytes)
+    {
+        Segment& segment = segments_.front();
+        if (!segment.prefix.empty())
+        {
+            // 前缀都很短，一次追加完
+            buf->append(segment.prefix);
+            filled += segment.prefix.size();
+            segment.prefix.clear();
+        }
+
+        // 追加前缀后可能已经超过maxBytes
+        size_t len = filled < maxBytes ? std::min(segment.length, maxBytes - filled) : 0;
+        if (len > 0)
+        {
+            buf->ensureWritableBytes(len);
+            ssize_t n = file_->read(segment.offset, buf->beginWrite(), len);
+            if (n <= 0)
+            {
+                // 文件在发送过程中被截断，已声明的Content-Length无法满足
+                LOG_ERROR << "FileTransfer read " << file_->path() << " at " << segment.offset << " failed";
+                return -1;
+            }
+            buf->hasWritten(n);
+            filled += n;
+            segment.offset += n;
+            segment.length -= n;
+        }
+
+        if (segment.length == 0)
+        {
+            segments_.pop_front();
+        }
+    }
+    return static_cast<ssize_t>(filled);
+}
+
+} // namespace http
@@ -1,4 +1,7 @@
 #include "../../include/http/HttpContext.h"
+#include "../../include/http/HttpScanner.h"
+
+#include <algorithm>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -6,6 +9,73 @@ using namespace muduo::net;
 namespace http
 {
 
+namespace
+{
+
+const size_t kMaxHeaderSize = 64 * 1024; // 请求行加请求头的最大长度
+const size_t kMaxChunkLine = 4096; // 块大小行(含块扩展)的最大长度
+const size_t kMaxChunkSizeDigits = 15; // 块大小最多15个十六进制数字，避免溢出
+
+// 解析 Content-Length，只允许十进制数字
+bool parseContentLength(std::string_view str, uint64_t *length)
+{
+    if (str.empty() || str.size() > 18)
+    {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : str)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    *length = result;
+    return true;
+}
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+    {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+    {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+// 解析块大小行 "1a3f[;ext=value]"，块扩展直接忽略
+bool parseChunkSize(std::string_view line, uint64_t *size)
+{
+    size_t semicolon = line.find(';');
+    std::string_view digits = trim(line.substr(0, semicolon));
+    if (digits.empty() || digits.size() > kMaxChunkSizeDigits)
+    {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : digits)
+    {
+        int value;
+        if (c >= '0' && c <= '9') value = c - '0';
+        else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else return false;
+        result = result * 16 + value;
+    }
+    *size = result;
+    return true;
+}
+
+const BodyOptions kDefaultBodyOptions; // 没有设置查询回调时使用
+
+} // namespace
+
 // 将报文解析出来将关键信息封装到HttpRequest对象里面去
 bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
 {
@@ -13,106 +83,350 @@ bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
     bool hasMore = true;
     while (hasMore)
     {
-        if (state_ == kExpectRequestLine)
+        if (state_ == kExpectHeaders)
         {
-            const char *crlf = buf->findCRLF(); // 注意这个返回值边界可能有错
-            if (crlf)
+            // 每次读取后只切分新到达的完整行，遇到空行时请求头已经切分完毕
+            const char *headEnd = nullptr;
+            if (!scanHead(buf->peek(), buf->beginWrite(), &headEnd))
             {
-                ok = processRequestLine(buf->peek(), crlf);
-                if (ok)
-                {
-                    request_.setReceiveTime(receiveTime);
-                    buf->retrieveUntil(crlf + 2);
-                    state_ = kExpectHeaders;
-                }
-                else
+                ok = false;
+                hasMore = false;
+                break;
+            }
+            if (!headEnd)
+            {
+                if (buf->readableBytes() > kMaxHeaderSize)
                 {
-                    hasMore = false;
+                    ok = false; // 请求头过大
                 }
+                hasMore = false;
+                break;
             }
-            else
+
+            ok = processHead(buf->peek(), headEnd);
+            buf->retrieveUntil(headEnd);
+            if (!ok)
             {
                 hasMore = false;
+                break;
             }
-        }
-        else if (state_ == kExpectHeaders)
-        {
-            const char *crlf = buf->findCRLF();
-            if (crlf)
+            request_.setReceiveTime(receiveTime);
+
+            if (!prepareBody())
             {
-                const char *colon = std::find(buf->peek(), crlf, ':');
-                if (colon < crlf)
-                {
-                    request_.addHeader(buf->peek(), colon, crlf);
-                }
-                else if (buf->peek() == crlf)
-                { 
-                    // 空行，结束Header
-                    // 根据请求方法和Content-Length判断是否需要继续读取body
-                    if (request_.method() == HttpRequest::kPost || 
-                        request_.method() == HttpRequest::kPut)
-                    {
-                        std::string contentLength = request_.getHeader("Content-Length");
-                        if (!contentLength.empty())
-                        {
-                            request_.setContentLength(std::stoi(contentLength));
-                            if (request_.contentLength() > 0)
-                            {
-                                state_ = kExpectBody;
-                            }
-                            else
-                            {
-                                state_ = kGotAll;
-                                hasMore = false;
-                            }
-                        }
-                        else
-                        {
-                            // POST/PUT 请求没有 Content-Length，是HTTP语法错误
-                            ok = false;
-                            hasMore = false;
-                        }
-                    }
-                    else
-                    {
-                        // GET/HEAD/DELETE 等方法直接完成（没有请求体）
-                        state_ = kGotAll; 
-                        hasMore = false;
-                    }
-                }
-                else
-                {
-                    ok = false; // Header行格式错误
-                    hasMore = false;
-                }
-                buf->retrieveUntil(crlf + 2); // 开始读指针指向下一行数据
+                ok = false;
+                hasMore = false;
             }
-            else
+            else if (state_ == kGotAll)
             {
                 hasMore = false;
             }
         }
         else if (state_ == kExpectBody)
         {
-            // 检查缓冲区中是否有足够的数据
-            if (buf->readableBytes() < request_.contentLength())
+            // 已到达的部分立即取走，输入缓冲区中不会积压整个请求体
+            size_t n = static_cast<size_t>(std::min<uint64_t>(
+                request_.contentLength() - bodyReceived_, buf->readableBytes()));
+            ok = appendBody(buf->peek(), n);
+            buf->retrieve(n);
+            if (ok && bodyReceived_ == request_.contentLength())
             {
-                hasMore = false; // 数据不完整，等待更多数据
-                return true;
+                state_ = kGotAll;
+            }
+            hasMore = false;
+        }
+        else if (state_ == kExpectChunkSize || state_ == kExpectChunkData ||
+                 state_ == kExpectChunkEnd || state_ == kExpectTrailers)
+        {
+            ok = parseChunked(buf);
+            hasMore = false;
+        }
+        else
+        {
+            hasMore = false;
+        }
+    }
+    if (!ok && error_ == kNoError)
+    {
+        error_ = kBadRequest;
+    }
+    return ok; // ok为false时由error()给出错误类型
+}
+
+bool HttpContext::prepareBody()
+{
+    // 请求体边界只能有一种解释 (RFC 9112 6.3): 重复的Transfer-Encoding直接拒绝，
+    // 重复的Content-Length值相同时合并为一个，不同时拒绝，否则前后两跳可能按不同的长度切分请求
+    bool hasTransferEncoding = false;
+    bool hasContentLength = false;
+    std::string_view transferEncoding;
+    std::string_view contentLength;
+    for (const HttpRequest::Header& header : request_.headers())
+    {
+        HttpHeader::Id id = HttpHeader::lookup(header.first);
+        if (id == HttpHeader::kTransferEncoding)
+        {
+            if (hasTransferEncoding)
+            {
+                return false;
+            }
+            hasTransferEncoding = true;
+            transferEncoding = header.second;
+        }
+        else if (id == HttpHeader::kContentLength)
+        {
+            std::string_view value = trim(header.second);
+            if (hasContentLength && value != contentLength)
+            {
+                return false;
+            }
+            hasContentLength = true;
+            contentLength = value;
+        }
+    }
+    if (hasTransferEncoding)
+    {
+        // 同时带两个长度头是请求走私的常见手法，直接拒绝
+        // 其他传输编码(如gzip)无法确定请求体边界，只接受单独的chunked
+        if (hasContentLength || !HttpHeader::equals(trim(transferEncoding), "chunked"))
+        {
+            return false;
+        }
+        state_ = kExpectChunkSize;
+        prepareBodyOptions();
+        return true;
+    }
+
+    if (hasContentLength)
+    {
+        // 空值或非数字的长度由parseContentLength拒绝
+        uint64_t length = 0;
+        if (!parseContentLength(contentLength, &length))
+        {
+            return false;
+        }
+        request_.setContentLength(length);
+        state_ = length > 0 ? kExpectBody : kGotAll;
+        if (length > 0)
+        {
+            prepareBodyOptions();
+            // 声明的长度已经超限，不读取任何请求体直接拒绝
+            if (length > bodyOptions_->maxSize)
+            {
+                error_ = kPayloadTooLarge;
+                return false;
             }
+        }
+        return true;
+    }
+
+    // POST/PUT 请求没有任何长度信息，是HTTP语法错误；GET/HEAD/DELETE 等方法没有请求体
+    if (request_.method() == HttpRequest::kPost || request_.method() == HttpRequest::kPut)
+    {
+        return false;
+    }
+    state_ = kGotAll;
+    return true;
+}
+
+void HttpContext::prepareBodyOptions()
+{
+    bodyOptions_ = bodyOptionsCallback_ ? &bodyOptionsCallback_(request_) : &kDefaultBodyOptions;
+    if (bodyOptions_->readerFactory)
+    {
+        request_.setBodyReader(bodyOptions_->readerFactory(request_));
+    }
+}
 
-            // 只读取 Content-Length 指定的长度
-            std::string body(buf->peek(), buf->peek() + request_.contentLength());
-            request_.setBody(body);
+bool HttpContext::appendBody(const char *data, size_t len)
+{
+    bodyReceived_ += len;
+    if (bodyReceived_ > bodyOptions_->maxSize)
+    {
+        error_ = kPayloadTooLarge;
+        return false;
+    }
+    if (len == 0)
+    {
+        return true;
+    }
+
+    if (BodyReader *reader = request_.bodyReader())
+    {
+        return reader->onData(data, len);
+    }
+    BodyFile *file = request_.bodyFile();
+    if (!file && bodyOptions_->spillThreshold > 0 
+        && request_.getBody().size() + len > bodyOptions_->spillThreshold)
+    {
+        // 超过内存阈值，已接收的部分和之后的数据都写入临时文件
+        std::unique_ptr<BodyFile> spill = BodyFile::create(bodyOptions_->spillDir);
+        if (!spill || !spill->append(request_.getBody().data(), request_.getBody().size()))
+        {
+            error_ = kInternalError;
+            return false;
+        }
+        file = spill.get();
+        request_.setBodyFile(std::move(spill));
+    }
+    if (file)
+    {
+        if (!file->append(data, len))
+        {
+            error_ = kInternalError;
+            return false;
+        }
+        return true;
+    }
+    request_.appendBody(data, len);
+    return true;
+}
 
-            // 准确移动读指针
-            buf->retrieve(request_.contentLength());
+bool HttpContext::parseChunked(Buffer *buf)
+{
+    while (state_ != kGotAll)
+    {
+        if (state_ == kExpectChunkData)
+        {
+            // 块数据可能分多次到达，每次把已到达的部分追加到请求体
+            size_t n = static_cast<size_t>(std::min<uint64_t>(chunkRemaining_, buf->readableBytes()));
+            bool ok = appendBody(buf->peek(), n);
+            buf->retrieve(n);
+            if (!ok)
+            {
+                return false;
+            }
+            chunkRemaining_ -= n;
+            if (chunkRemaining_ > 0)
+            {
+                return true; // 等待更多数据
+            }
+            state_ = kExpectChunkEnd;
+            continue;
+        }
 
+        if (state_ == kExpectChunkEnd)
+        {
+            if (buf->readableBytes() < 2)
+            {
+                return true;
+            }
+            if (buf->peek()[0] != '\r' || buf->peek()[1] != '\n')
+            {
+                return false;
+            }
+            buf->retrieve(2);
+            state_ = kExpectChunkSize;
+            continue;
+        }
+
+        // 块大小行和trailer都是以CRLF结尾的行
+        const char *crlf = scanner::findCRLF(buf->peek(), buf->beginWrite());
+        if (!crlf)
+        {
+            size_t limit = state_ == kExpectTrailers ? kMaxHeaderSize : kMaxChunkLine;
+            return buf->readableBytes() <= limit;
+        }
+        std::string_view line(buf->peek(), crlf - buf->peek());
+        buf->retrieveUntil(crlf + 2);
+
+        if (state_ == kExpectChunkSize)
+        {
+            if (!parseChunkSize(line, &chunkRemaining_))
+            {
+                return false;
+            }
+            // 块大小已经超出剩余的额度时不读取这一块
+            if (chunkRemaining_ > bodyOptions_->maxSize - bodyReceived_)
+            {
+                error_ = kPayloadTooLarge;
+                return false;
+            }
+            // 大小为0的块是最后一块，之后是可选的trailer
+            state_ = chunkRemaining_ > 0 ? kExpectChunkData : kExpectTrailers;
+        }
+        else if (line.empty())
+        {
+            // trailer以空行结束，请求体完整，trailer中的字段不使用
+            request_.setContentLength(bodyReceived_);
             state_ = kGotAll;
-            hasMore = false;
         }
     }
-    return ok; // ok为false代表报文语法解析错误
+    return true;
+}
+
+// 在同一次扫描中找到行尾并切分header，数据不完整时记录已切分的位置，下次从这里继续
+// 只切分完整的行: 不完整的行先用findCRLF确认行尾已到达，每个字节只被扫描一次
+bool HttpContext::scanHead(const char *begin, const char *end, const char **headEnd)
+{
+    // 上次停在不完整的行上，新数据中还没有CRLF时不必重新切分这一行
+    const char *crlf = scanner::findCRLF(begin + std::max(scanned_, lineScanned_), end);
+    if (!crlf)
+    {
+        size_t len = end - begin;
+        lineScanned_ = len > 1 ? len - 1 : 0; // 回退1个字节，避免漏掉被两次读取分开的CRLF
+        return true;
+    }
+
+    if (requestLineEnd_ == 0)
+    {
+        // 请求行之前的数据都没有CRLF，找到的就是请求行的结尾
+        if (crlf == begin)
+        {
+            return false; // 空的请求行
+        }
+        requestLineEnd_ = crlf - begin;
+        scanned_ = requestLineEnd_ + 2;
+    }
+
+    const char *p = begin + scanned_;
+    while (true)
+    {
+        scanner::HeaderSpan span;
+        const char *next = nullptr;
+        scanner::LineResult result = scanner::parseHeaderLine(p, end, &span, &next);
+        if (result == scanner::kHeader)
+        {
+            headerOffsets_.push_back({ static_cast<size_t>(span.nameBegin - begin),
+                                       static_cast<size_t>(span.nameEnd - begin),
+                                       static_cast<size_t>(span.valueBegin - begin),
+                                       static_cast<size_t>(span.valueEnd - begin) });
+            p = next;
+            scanned_ = p - begin;
+        }
+        else if (result == scanner::kEmptyLine)
+        {
+            *headEnd = next;
+            return true;
+        }
+        else if (result == scanner::kIncomplete)
+        {
+            // 剩下的数据中没有CRLF，最多只有末尾的 '\r'
+            size_t len = end - begin;
+            lineScanned_ = std::max(scanned_, len > 1 ? len - 1 : 0);
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+}
+
+// 把请求头拷贝到请求自身的缓冲区中，按scanHead记录的偏移设置请求行和各个header
+bool HttpContext::processHead(const char *begin, const char *end)
+{
+    const char *head = request_.assignRaw(begin, end - begin);
+    if (!processRequestLine(head, head + requestLineEnd_))
+    {
+        return false;
+    }
+    for (const HeaderOffsets& offsets : headerOffsets_)
+    {
+        request_.addHeader(head + offsets.nameBegin, head + offsets.nameEnd,
+                           head + offsets.valueBegin, head + offsets.valueEnd);
+    }
+    return true;
 }
 
 // 解析请求行
@@ -120,14 +434,14 @@ bool HttpContext::processRequestLine(const char *begin, const char *end)
 {
     bool succeed = false;
     const char *start = begin;
-    const char *space = std::find(start, end, ' ');
+    const char *space = scanner::findEither(start, end, ' ', ' ');
     if (space != end && request_.setMethod(start, space))
     {
         start = space + 1;
-        space = std::find(start, end, ' ');
+        space = scanner::findEither(start, end, ' ', ' ');
         if (space != end)
         {
-            const char *argumentStart = std::find(start, space, '?');
+            const char *argumentStart = scanner::findEither(start, space, '?', '?');
             if (argumentStart != space) // 请求带参数
             {
                 request_.setPath(start, argumentStart); // 注意这些返回值边界
@@ -144,11 +458,11 @@ bool HttpContext::processRequestLine(const char *begin, const char *end)
             {
                 if (*(end - 1) == '1')
                 {
-                    request_.setVersion("HTTP/1.1");
+                    request_.setVersion(HttpRequest::kHttp11);
                 }
                 else if (*(end - 1) == '0')
                 {
-                    request_.setVersion("HTTP/1.0");
+                    request_.setVersion(HttpRequest::kHttp10);
                 }
                 else
                 {
@@ -160,4 +474,4 @@ bool HttpContext::processRequestLine(const char *begin, const char *end)
     return succeed;
 }
 
-} // namespace http
\ No newline at end of file
+} // namespace http
@@ -0,0 +1,144 @@
+#include "../../include/http/HttpHeader.h"
+
+#include <array>
+#include <cstdint>
+
+namespace http
+{
+
+namespace
+{
+
+// 顺序必须与 HttpHeader::Id 一致
+constexpr std::string_view kNames[HttpHeader::kNumKnownHeaders] = {
+    "Accept",
+    "Accept-Charset",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Access-Control-Request-Headers",
+    "Access-Control-Request-Method",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "Expect",
+    "Forwarded",
+    "From",
+    "Host",
+    "If-Match",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "If-Unmodified-Since",
+    "Keep-Alive",
+    "Max-Forwards",
+    "Origin",
+    "Pragma",
+    "Proxy-Authorization",
+    "Range",
+    "Referer",
+    "Sec-WebSocket-Key",
+    "Sec-WebSocket-Version",
+    "TE",
+    "Trailer",
+    "Transfer-Encoding",
+    "Upgrade",
+    "User-Agent",
+    "Via",
+    "X-Forwarded-For",
+    "X-Forwarded-Proto",
+    "X-Real-IP",
+    "X-Requested-With",
+};
+
+const size_t kTableSize = 128;
+
+constexpr unsigned char toLower(char c)
+{
+    return static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+}
+
+// 由长度、首字符、尾字符和中间字符组成的哈希，系数按上表离线选出，
+// 保证上表中的名字两两不冲突(见下面的static_assert)，name不能为空
+constexpr size_t hashName(std::string_view name)
+{
+    return (name.size()
+            + toLower(name[0]) * 19
+            + toLower(name[name.size() - 1]) * 9
+            + toLower(name[name.size() / 2])) % kTableSize;
+}
+
+// 哈希值 -> Id，空槽为kUnknown
+constexpr std::array<uint8_t, kTableSize> buildTable()
+{
+    std::array<uint8_t, kTableSize> table = {};
+    for (size_t i = 0; i < kTableSize; ++i)
+    {
+        table[i] = HttpHeader::kUnknown;
+    }
+    for (size_t i = 0; i < HttpHeader::kNumKnownHeaders; ++i)
+    {
+        table[hashName(kNames[i])] = static_cast<uint8_t>(i);
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, kTableSize> kTable = buildTable();
+
+// 每个名字都占据自己的槽，说明没有冲突
+constexpr bool isPerfect()
+{
+    for (size_t i = 0; i < HttpHeader::kNumKnownHeaders; ++i)
+    {
+        if (kTable[hashName(kNames[i])] != i)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isPerfect(), "header name hash has collisions, choose new coefficients");
+
+} // namespace
+
+HttpHeader::Id HttpHeader::lookup(std::string_view name)
+{
+    if (name.empty())
+    {
+        return kUnknown;
+    }
+    uint8_t id = kTable[hashName(name)];
+    if (id != kUnknown && equals(name, kNames[id]))
+    {
+        return static_cast<Id>(id);
+    }
+    return kUnknown;
+}
+
+std::string_view HttpHeader::name(Id id)
+{
+    return id < kNumKnownHeaders ? kNames[id] : std::string_view();
+}
+
+bool HttpHeader::equals(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (toLower(a[i]) != toLower(b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace http
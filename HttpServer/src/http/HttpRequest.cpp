@@ -3,6 +3,83 @@
 namespace http
 {
 
+HttpRequest::HttpRequest(const HttpRequest &that)
+    : method_(kInvalid)
+    , version_(kUnknown)
+{
+    copyFrom(that);
+}
+
+HttpRequest &HttpRequest::operator=(const HttpRequest &that)
+{
+    if (this != &that)
+    {
+        copyFrom(that);
+    }
+    return *this;
+}
+
+void HttpRequest::copyFrom(const HttpRequest &that)
+{
+    raw_ = that.raw_;
+    method_ = that.method_;
+    version_ = that.version_;
+    path_ = rebase(that.path_, that);
+    query_ = rebase(that.query_, that);
+    pathParameters_ = that.pathParameters_;
+    pathParams_.clear();
+    for (const auto &[name, value] : that.pathParams_)
+    {
+        pathParams_.emplace_back(name, rebase(value, that)); // 参数名指向路由树，不需要调整
+    }
+    receiveTime_ = that.receiveTime_;
+    headers_.clear();
+    for (const Header &header : that.headers_)
+    {
+        headers_.emplace_back(rebase(header.first, that), rebase(header.second, that));
+    }
+    knownHeaders_ = that.knownHeaders_;
+    content_ = that.content_;
+    bodyFile_ = that.bodyFile_;
+    bodyReader_ = that.bodyReader_;
+    contentLength_ = that.contentLength_;
+}
+
+// 把指向that.raw_的视图换算成指向本对象raw_中相同位置的视图
+std::string_view HttpRequest::rebase(std::string_view view, const HttpRequest &that) const
+{
+    const char *base = that.raw_.data();
+    if (base != nullptr && view.data() >= base && view.data() <= base + that.raw_.size())
+    {
+        return std::string_view(raw_.data() + (view.data() - base), view.size());
+    }
+    return view;
+}
+
+void HttpRequest::clear()
+{
+    raw_.clear();
+    method_ = kInvalid;
+    version_ = kUnknown;
+    path_ = std::string_view();
+    query_ = std::string_view();
+    pathParameters_.clear();
+    pathParams_.clear();
+    receiveTime_ = muduo::Timestamp();
+    headers_.clear();
+    knownHeaders_.fill(0);
+    content_.clear();
+    bodyFile_.reset();
+    bodyReader_.reset();
+    contentLength_ = 0;
+}
+
+const char *HttpRequest::assignRaw(const char *data, size_t len)
+{
+    raw_.assign(data, data + len); // 容量足够时不重新分配
+    return raw_.data();
+}
+
 void HttpRequest::setReceiveTime(muduo::Timestamp t)
 {
     receiveTime_ = t;
@@ -11,7 +88,7 @@ void HttpRequest::setReceiveTime(muduo::Timestamp t)
 bool HttpRequest::setMethod(const char *start, const char *end)
 {
     assert(method_ == kInvalid);
-    std::string m(start, end); // [start, end)
+    std::string_view m(start, end - start); // [start, end)
     if (m == "GET")
     {
         method_ = kGet;
@@ -20,6 +97,10 @@ bool HttpRequest::setMethod(const char *start, const char *end)
     {
         method_ = kPost;
     }
+    else if (m == "HEAD")
+    {
+        method_ = kHead;
+    }
     else if (m == "PUT")
     {
         method_ = kPut;
@@ -40,11 +121,6 @@ bool HttpRequest::setMethod(const char *start, const char *end)
     return method_ != kInvalid;
 }
 
-void HttpRequest::setPath(const char *start, const char *end)
-{
-    path_.assign(start, end);
-}
-
 void HttpRequest::setPathParameters(const std::string &key, const std::string &value)
 {
     pathParameters_[key] = value;
@@ -57,89 +133,96 @@ std::string HttpRequest::getPathParameters(const std::string &key) const
     {
         return it->second;
     }
-    return "";
+    return std::string(pathParam(key));
 }
 
-std::string HttpRequest::getQueryParameters(const std::string &key) const
+std::string_view HttpRequest::pathParam(std::string_view key) const
 {
-    auto it = queryParameters_.find(key);
-    if (it != queryParameters_.end())
+    for (const auto &[name, value] : pathParams_)
     {
-        return it->second;
+        if (name == key)
+        {
+            return value;
+        }
     }
-    return "";
+    return std::string_view();
 }
 
-// 这是从问号后面分割参数
-void HttpRequest::setQueryParameters(const char *start, const char *end)
+std::string_view HttpRequest::getQueryParameters(std::string_view key) const
 {
-    std::string argumentStr(start, end);
-    std::string::size_type pos = 0;
-    std::string::size_type prev = 0;
-
-    // 按 & 分割多个参数
-    while ((pos = argumentStr.find('&', prev)) != std::string::npos)
+    // 按 & 分割多个参数，逐个比较参数名，参数名重复时取最后一个
+    std::string_view rest = query_;
+    std::string_view result;
+    while (!rest.empty())
     {
-        std::string pair = argumentStr.substr(prev, pos - prev);
-        std::string::size_type equalPos = pair.find('=');
+        size_t amp = rest.find('&');
+        std::string_view pair = rest.substr(0, amp);
+        rest = amp == std::string_view::npos ? std::string_view() : rest.substr(amp + 1);
 
-        if (equalPos != std::string::npos)
+        size_t equalPos = pair.find('=');
+        if (equalPos != std::string_view::npos && pair.substr(0, equalPos) == key)
         {
-            std::string key = pair.substr(0, equalPos);
-            std::string value = pair.substr(equalPos + 1);
-            queryParameters_[key] = value;
+            result = pair.substr(equalPos + 1);
         }
-
-        prev = pos + 1;
     }
+    return result;
+}
 
-    // 处理最后一个参数
-    std::string lastPair = argumentStr.substr(prev);
-    std::string::size_type equalPos = lastPair.find('=');
-    if (equalPos != std::string::npos)
-    {
-        std::string key = lastPair.substr(0, equalPos);
-        std::string value = lastPair.substr(equalPos + 1);
-        queryParameters_[key] = value;
-    }
+const std::string &HttpRequest::getVersion() const
+{
+    static const std::string kVersions[] = {"Unknown", "HTTP/1.0", "HTTP/1.1"};
+    return kVersions[version_];
 }
 
-void HttpRequest::addHeader(const char *start, const char *colon, const char *end)
+void HttpRequest::addHeader(const char *nameBegin, const char *nameEnd, const char *valueBegin, const char *valueEnd)
 {
-    std::string key(start, colon);
-    ++colon;
-    while (colon < end && isspace(*colon))
-    {
-        ++colon;
-    }
-    std::string value(colon, end);
-    while (!value.empty() && isspace(value[value.size() - 1])) // 消除尾部空格
+    std::string_view name(nameBegin, nameEnd - nameBegin);
+    headers_.emplace_back(name, std::string_view(valueBegin, valueEnd - valueBegin));
+
+    // 已知header在解析时识别一次，记下第一次出现的位置
+    HttpHeader::Id id = HttpHeader::lookup(name);
+    if (id != HttpHeader::kUnknown && knownHeaders_[id] == 0 && headers_.size() <= UINT16_MAX)
     {
-        value.resize(value.size() - 1);
+        knownHeaders_[id] = static_cast<uint16_t>(headers_.size());
     }
-    headers_[key] = value;
 }
 
-std::string HttpRequest::getHeader(const std::string &field) const
+std::string_view HttpRequest::getHeader(std::string_view field) const
 {
-    std::string result;
-    auto it = headers_.find(field);
-    if (it != headers_.end())
+    HttpHeader::Id id = HttpHeader::lookup(field);
+    if (id != HttpHeader::kUnknown)
     {
-        result = it->second;
+        return getHeader(id);
     }
-    return result;
+
+    // 自定义header数量很少，线性查找比哈希表更快且不需要分配内存
+    for (const Header &header : headers_)
+    {
+        if (HttpHeader::equals(header.first, field))
+        {
+            return header.second;
+        }
+    }
+    return std::string_view();
 }
 
 void HttpRequest::swap(HttpRequest &that)
 {
+    // vector交换的是缓冲区指针，视图跟随各自的缓冲区，仍然有效
+    raw_.swap(that.raw_);
     std::swap(method_, that.method_);
+    std::swap(version_, that.version_);
     std::swap(path_, that.path_);
+    std::swap(query_, that.query_);
     std::swap(pathParameters_, that.pathParameters_);
-    std::swap(queryParameters_, that.queryParameters_);
-    std::swap(version_, that.version_);
-    std::swap(headers_, that.headers_);
+    std::swap(pathParams_, that.pathParams_);
     std::swap(receiveTime_, that.receiveTime_);
+    std::swap(headers_, that.headers_);
+    std::swap(knownHeaders_, that.knownHeaders_);
+    std::swap(content_, that.content_);
+    std::swap(bodyFile_, that.bodyFile_);
+    std::swap(bodyReader_, that.bodyReader_);
+    std::swap(contentLength_, that.contentLength_);
 }
 
-} // namespace http
\ No newline at end of file
+} // namespace http
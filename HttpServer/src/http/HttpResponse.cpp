@@ -1,40 +1,207 @@
 #include "../../include/http/HttpResponse.h"
 
+#include <cstring>
+#include <string_view>
+
 namespace http
 {
 
-void HttpResponse::appendToBuffer(muduo::net::Buffer* outputBuf) const
+namespace
+{
+
+const char kServerHeader[] = "Server: HttpServer\r\n";
+const char kCloseHeader[] = "Connection: close\r\n";
+const char kKeepAliveHeader[] = "Connection: Keep-Alive\r\n";
+const char kCRLF[] = "\r\n";
+
+const int kMaxStatusCode = 600;
+
+struct StatusEntry
+{
+    HttpResponse::HttpStatusCode code;
+    const char*                  reason;
+};
+
+const StatusEntry kStatusEntries[] = {
+    { HttpResponse::k200Ok, "OK" },
+    { HttpResponse::k204NoContent, "No Content" },
+    { HttpResponse::k206PartialContent, "Partial Content" },
+    { HttpResponse::k301MovedPermanently, "Moved Permanently" },
+    { HttpResponse::k304NotModified, "Not Modified" },
+    { HttpResponse::k400BadRequest, "Bad Request" },
+    { HttpResponse::k401Unauthorized, "Unauthorized" },
+    { HttpResponse::k403Forbidden, "Forbidden" },
+    { HttpResponse::k404NotFound, "Not Found" },
+    { HttpResponse::k408RequestTimeout, "Request Timeout" },
+    { HttpResponse::k409Conflict, "Conflict" },
+    { HttpResponse::k413PayloadTooLarge, "Payload Too Large" },
+    { HttpResponse::k416RangeNotSatisfiable, "Range Not Satisfiable" },
+    { HttpResponse::k500InternalServerError, "Internal Server Error" },
+    { HttpResponse::k503ServiceUnavailable, "Service Unavailable" },
+};
+
+// 每个已知状态码在HTTP/1.0和HTTP/1.1下的完整状态行，如 "HTTP/1.1 200 OK\r\n"
+// 程序启动时拼好一次，之后只读
+class StatusLines
+{
+public:
+    StatusLines()
+    {
+        for (const StatusEntry& entry : kStatusEntries)
+        {
+            std::string suffix = " " + std::to_string(entry.code) + " " + entry.reason + "\r\n";
+            reasons_[entry.code] = entry.reason;
+            lines_[entry.code][0] = "HTTP/1.0" + suffix;
+            lines_[entry.code][1] = "HTTP/1.1" + suffix;
+        }
+    }
+
+    const char* reason(int code) const
+    {
+        return code > 0 && code < kMaxStatusCode ? reasons_[code] : nullptr;
+    }
+
+    // http11为false时返回HTTP/1.0的状态行
+    const std::string& line(int code, bool http11) const
+    {
+        return lines_[code][http11 ? 1 : 0];
+    }
+
+private:
+    const char* reasons_[kMaxStatusCode] = {};
+    std::string lines_[kMaxStatusCode][2];
+};
+
+const StatusLines kStatusLines;
+
+const std::string kEmptyString;
+
+void put(char*& p, const char* data, size_t len)
+{
+    if (len > 0)
+    {
+        ::memcpy(p, data, len);
+        p += len;
+    }
+}
+
+void put(char*& p, const std::string& str)
+{
+    put(p, str.data(), str.size());
+}
+
+} // namespace
+
+const char* HttpResponse::reasonPhrase(HttpStatusCode code)
+{
+    const char* reason = kStatusLines.reason(code);
+    return reason ? reason : "";
+}
+
+void HttpResponse::addHeader(const std::string& key, const std::string& value)
+{
+    for (Header& header : headers_)
+    {
+        if (HttpHeader::equals(header.first, key))
+        {
+            header.second = value;
+            return;
+        }
+    }
+    headers_.emplace_back(key, value);
+}
+
+const std::string& HttpResponse::getHeader(const std::string& key) const
+{
+    for (const Header& header : headers_)
+    {
+        if (HttpHeader::equals(header.first, key))
+        {
+            return header.second;
+        }
+    }
+    return kEmptyString;
+}
+
+void HttpResponse::appendToBuffer(muduo::net::Buffer* outputBuf, bool withBody) const
 {
-    // HttpResponse封装的信息格式化输出
-    char buf[32]; 
-    // 为什么不把状态信息放入格式化字符串中，因为状态信息有长有短，不方便定义一个固定大小的内存存储
-    snprintf(buf, sizeof buf, "%s %d ", httpVersion_.c_str(), statusCode_);
-    
-    outputBuf->append(buf);
-    outputBuf->append(statusMessage_);
-    outputBuf->append("\r\n");
+    // 没有设置版本时按HTTP/1.1响应
+    bool http11 = httpVersion_ != "HTTP/1.0";
 
-    if (closeConnection_) // 思考一下这些地方是不是可以直接移入近headers_中
+    // 使用标准原因短语(或没有设置短语)的已知状态码直接取预先拼好的状态行
+    std::string customLine;
+    const char* reason = kStatusLines.reason(statusCode_);
+    const std::string* statusLine = nullptr;
+    if (reason && (statusMessage_.empty() || statusMessage_ == reason))
     {
-        outputBuf->append("Connection: close\r\n");
+        statusLine = &kStatusLines.line(statusCode_, http11);
     }
     else
     {
-        //snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", body_.size());
-        //outputBuf->append(buf);
-        outputBuf->append("Connection: Keep-Alive\r\n");
+        customLine = (http11 ? "HTTP/1.1 " : "HTTP/1.0 ") + std::to_string(statusCode_)
+                     + " " + statusMessage_ + "\r\n";
+        statusLine = &customLine;
     }
 
-    for (const auto& header : headers_)
-    { // 为什么这里不用格式化字符串？因为key和value的长度不定
-        outputBuf->append(header.first);
-        outputBuf->append(": "); 
-        outputBuf->append(header.second);
-        outputBuf->append("\r\n");
+    // HTTP/1.1默认保持连接，只有关闭时才需要说明；HTTP/1.0保持连接时必须显式说明
+    std::string_view connection;
+    if (closeConnection_)
+    {
+        connection = std::string_view(kCloseHeader, sizeof kCloseHeader - 1);
+    }
+    else if (!http11)
+    {
+        connection = std::string_view(kKeepAliveHeader, sizeof kKeepAliveHeader - 1);
+    }
+
+    // 先算出总长度，只扩容一次
+    bool hasDate = false;
+    bool hasServer = false;
+    size_t total = statusLine->size() + connection.size() + 2;
+    for (const Header& header : headers_)
+    {
+        total += header.first.size() + header.second.size() + 4;
+        hasDate = hasDate || HttpHeader::equals(header.first, "Date");
+        hasServer = hasServer || HttpHeader::equals(header.first, "Server");
+    }
+    std::string_view date;
+    if (!hasDate)
+    {
+        date = DateCache::header();
+        total += date.size();
+    }
+    if (!hasServer)
+    {
+        total += sizeof kServerHeader - 1;
+    }
+    const std::string& content = body();
+    if (withBody)
+    {
+        total += content.size();
+    }
+
+    outputBuf->ensureWritableBytes(total);
+    char* p = outputBuf->beginWrite();
+    put(p, *statusLine);
+    put(p, date.data(), date.size());
+    if (!hasServer)
+    {
+        put(p, kServerHeader, sizeof kServerHeader - 1);
+    }
+    put(p, connection.data(), connection.size());
+    for (const Header& header : headers_)
+    {
+        put(p, header.first);
+        put(p, ": ", 2);
+        put(p, header.second);
+        put(p, kCRLF, 2);
+    }
+    put(p, kCRLF, 2);
+    if (withBody)
+    {
+        put(p, content);
     }
-    outputBuf->append("\r\n");
-    
-    outputBuf->append(body_);
+    outputBuf->hasWritten(total);
 }
 
 void HttpResponse::setStatusLine(const std::string& version,
@@ -46,4 +213,4 @@ void HttpResponse::setStatusLine(const std::string& version,
     statusMessage_ = statusMessage;
 }
 
-} // namespace http
\ No newline at end of file
+} // namespace http
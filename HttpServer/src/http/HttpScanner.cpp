@@ -0,0 +1,233 @@
+#include "../../include/http/HttpScanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCANNER_X86 1
+#endif
+
+namespace http
+{
+namespace scanner
+{
+
+namespace
+{
+
+const char* findEitherScalar(const char* p, const char* end, char a, char b)
+{
+    for (; p < end; ++p)
+    {
+        if (*p == a || *p == b)
+        {
+            return p;
+        }
+    }
+    return end;
+}
+
+#ifdef HTTP_SCANNER_X86
+
+// 与 picohttpparser 相同，用 pcmpestri 的 EQUAL_ANY 模式一次比较16个字节
+__attribute__((target("sse4.2")))
+const char* findEitherSse42(const char* p, const char* end, char a, char b)
+{
+    const __m128i needles = _mm_setr_epi8(a, b, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    while (end - p >= 16)
+    {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int idx = _mm_cmpestri(needles, 2, data, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (idx != 16)
+        {
+            return p + idx;
+        }
+        p += 16;
+    }
+    return findEitherScalar(p, end, a, b);
+}
+
+// 一次比较32个字节，两次比较结果合并后用movemask取出位图，最低的置位即第一个匹配
+__attribute__((target("avx2")))
+const char* findEitherAvx2(const char* p, const char* end, char a, char b)
+{
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    while (end - p >= 32)
+    {
+        __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i match = _mm256_or_si256(_mm256_cmpeq_epi8(data, va), _mm256_cmpeq_epi8(data, vb));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(match));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return findEitherSse42(p, end, a, b); // 支持AVX2的CPU一定支持SSE4.2
+}
+
+#endif
+
+using FindFunc = const char* (*)(const char*, const char*, char, char);
+
+struct Implementation
+{
+    FindFunc    find;
+    const char* name;
+};
+
+Implementation selectImplementation()
+{
+#ifdef HTTP_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return Implementation{findEitherAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        return Implementation{findEitherSse42, "sse4.2"};
+    }
+#endif
+    return Implementation{findEitherScalar, "scalar"};
+}
+
+const Implementation kImpl = selectImplementation();
+
+// RFC 9110 5.6.2 token中允许的字符: 字母、数字和 !#$%&'*+-.^_`|~
+// 编译期生成256项的查找表，校验字段名时每个字节只查一次表
+struct TokenTable
+{
+    bool allowed[256];
+
+    constexpr TokenTable()
+        : allowed()
+    {
+        for (int c = 'a'; c <= 'z'; ++c)
+        {
+            allowed[c] = true;
+        }
+        for (int c = 'A'; c <= 'Z'; ++c)
+        {
+            allowed[c] = true;
+        }
+        for (int c = '0'; c <= '9'; ++c)
+        {
+            allowed[c] = true;
+        }
+        for (const char* s = "!#$%&'*+-.^_`|~"; *s; ++s)
+        {
+            allowed[static_cast<unsigned char>(*s)] = true;
+        }
+    }
+};
+
+constexpr TokenTable kTokenTable;
+
+inline bool isTokenChar(unsigned char c)
+{
+    return kTokenTable.allowed[c];
+}
+
+} // namespace
+
+const char* findEither(const char* begin, const char* end, char a, char b)
+{
+    return kImpl.find(begin, end, a, b);
+}
+
+const char* findCRLF(const char* begin, const char* end)
+{
+    if (end - begin < 2)
+    {
+        return nullptr;
+    }
+    const char* p = begin;
+    while ((p = kImpl.find(p, end, '\r', '\r')) < end - 1)
+    {
+        if (p[1] == '\n')
+        {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+LineResult parseHeaderLine(const char* begin, const char* end, HeaderSpan* span, const char** next)
+{
+    // 第一次扫描同时找 ':' 和 '\r'，header名中不允许出现 '\r'
+    const char* p = kImpl.find(begin, end, ':', '\r');
+    if (p == end)
+    {
+        return kIncomplete;
+    }
+    if (*p == '\r')
+    {
+        if (p + 1 == end)
+        {
+            return kIncomplete;
+        }
+        if (p[1] != '\n')
+        {
+            return kBadLine;
+        }
+        if (p != begin)
+        {
+            return kBadLine; // 没有 ':' 的header行
+        }
+        *next = p + 2;
+        return kEmptyLine;
+    }
+    if (p == begin)
+    {
+        return kBadLine; // header名为空
+    }
+    // header名只能由token字符组成，"Transfer-Encoding : chunked" 这样名字后带空白的行必须拒绝，
+    // 否则它会被当作未知header，绕过请求体长度的检查 (RFC 9112 5.1)
+    for (const char* c = begin; c < p; ++c)
+    {
+        if (!isTokenChar(static_cast<unsigned char>(*c)))
+        {
+            return kBadLine;
+        }
+    }
+
+    // 从 ':' 之后继续扫描到行尾
+    const char* colon = p;
+    const char* cr = kImpl.find(colon + 1, end, '\r', '\r');
+    if (cr + 1 >= end)
+    {
+        return kIncomplete;
+    }
+    if (cr[1] != '\n')
+    {
+        return kBadLine;
+    }
+
+    const char* valueBegin = colon + 1;
+    const char* valueEnd = cr;
+    while (valueBegin < valueEnd && (*valueBegin == ' ' || *valueBegin == '\t'))
+    {
+        ++valueBegin;
+    }
+    while (valueEnd > valueBegin && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t'))
+    {
+        --valueEnd;
+    }
+
+    span->nameBegin = begin;
+    span->nameEnd = colon;
+    span->valueBegin = valueBegin;
+    span->valueEnd = valueEnd;
+    *next = cr + 2;
+    return kHeader;
+}
+
+const char* implementation()
+{
+    return kImpl.name;
+}
+
+} // namespace scanner
+} // namespace http
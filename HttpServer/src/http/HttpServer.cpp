@@ -1,14 +1,232 @@
 #include "../../include/http/HttpServer.h"
+#include "../../include/http/HttpScanner.h"
+
+#include <signal.h>
 
 #include <any>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <string_view>
 
 namespace http
 {
 
+namespace
+{
+
+const size_t kDefaultWorkerQueueSize = 1024; // 工作线程池默认最大排队数
+const double kSessionCleanInterval = 1.0; // 会话过期清理间隔(秒)
+const double kDateRefreshInterval = 1.0; // Date缓存刷新间隔(秒)
+const size_t kFileChunkSize = 64 * 1024; // 发送文件时每次读取的块大小
+const size_t kMaxFileBytesPerEvent = 1024 * 1024; // 每次写事件最多发送的文件字节数，避免一个连接独占IO线程
+const size_t kLargeBodySize = 8 * 1024; // 不小于这个大小的响应体不拷贝进输出队列
+const double kTimeoutCheckInterval = 1.0; // 连接超时时间轮的推进间隔(秒)
+const double kRejectCloseDelay = 1.0; // 拒绝连接时等待对端读取503的时间(秒)
+
+// 超过最大连接数时的响应，不经过解析器和序列化
+const char kServiceUnavailable[] =
+    "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+
+// 当前IO线程的连接超时时间轮，未启用超时时为空
+thread_local ConnectionTimer* t_connectionTimer = nullptr;
+
+// 收到SIGHUP后由主循环的定时检查发起证书重新加载
+std::atomic<bool> g_certificateReloadRequested(false);
+
+void onSighup(int)
+{
+    g_certificateReloadRequested = true;
+}
+
+// 请求解析失败时的错误响应，之后连接会被关闭
+void appendParseError(HttpContext::Error error, OutputQueue *output)
+{
+    HttpResponse response(true);
+    HttpResponse::HttpStatusCode code = HttpResponse::k400BadRequest;
+    if (error == HttpContext::kPayloadTooLarge)
+    {
+        code = HttpResponse::k413PayloadTooLarge;
+    }
+    else if (error == HttpContext::kInternalError)
+    {
+        code = HttpResponse::k500InternalServerError;
+    }
+    response.setStatusLine("HTTP/1.1", code, HttpResponse::reasonPhrase(code));
+    response.setContentLength(0);
+    response.appendToBuffer(output->buffer());
+}
+
+// 根据请求头和协议版本判断响应后是否需要关闭连接
+bool closeRequested(const HttpRequest &req)
+{
+    std::string_view connection = req.getHeader(HttpHeader::kConnection);
+    return (HttpHeader::equals(connection, "close") ||
+            (req.version() == HttpRequest::kHttp10 && !HttpHeader::equals(connection, "Keep-Alive")));
+}
+
+// 按 If-None-Match 的弱比较规则判断etag是否在列表中
+bool etagMatches(std::string_view list, const std::string &etag)
+{
+    if (etag.empty())
+    {
+        return false;
+    }
+    if (list == "*")
+    {
+        return true;
+    }
+    std::string_view target(etag);
+    if (target.substr(0, 2) == "W/")
+    {
+        target.remove_prefix(2);
+    }
+
+    std::string_view rest = list;
+    while (!rest.empty())
+    {
+        size_t comma = rest.find(',');
+        std::string_view item = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t'))
+        {
+            item.remove_prefix(1);
+        }
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t'))
+        {
+            item.remove_suffix(1);
+        }
+        if (item.substr(0, 2) == "W/")
+        {
+            item.remove_prefix(2);
+        }
+        if (item == target)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 根据请求的条件头判断客户端缓存是否仍然有效，有效时应返回304
+bool notModified(const HttpRequest &req, const HttpResponse &resp)
+{
+    if ((req.method() != HttpRequest::kGet && req.method() != HttpRequest::kHead) 
+        || resp.getStatusCode() != HttpResponse::k200Ok)
+    {
+        return false;
+    }
+
+    // 同时存在时 If-None-Match 优先，忽略 If-Modified-Since
+    std::string_view ifNoneMatch = req.getHeader(HttpHeader::kIfNoneMatch);
+    if (!ifNoneMatch.empty())
+    {
+        return etagMatches(ifNoneMatch, resp.getHeader("ETag"));
+    }
+
+    std::string_view ifModifiedSince = req.getHeader(HttpHeader::kIfModifiedSince);
+    std::string lastModified = resp.getHeader("Last-Modified");
+    if (ifModifiedSince.empty() || lastModified.empty())
+    {
+        return false;
+    }
+    time_t since = parseHttpDate(ifModifiedSince);
+    time_t modified = parseHttpDate(lastModified);
+    return since >= 0 && modified >= 0 && modified <= since;
+}
+
+// If-Range 与当前文件一致时才处理Range，否则返回整个文件
+bool ifRangeMatches(const HttpRequest &req, const HttpResponse &resp)
+{
+    std::string_view ifRange = req.getHeader(HttpHeader::kIfRange);
+    if (ifRange.empty())
+    {
+        return true;
+    }
+    if (ifRange.front() == '"')
+    {
+        // If-Range 要求强比较
+        return ifRange == resp.getHeader("ETag");
+    }
+    return ifRange == resp.getHeader("Last-Modified");
+}
+
+// 根据请求的Range头确定文件响应的状态码、响应头和需要发送的分段
+// 返回nullptr表示没有需要发送的内容(如416)
+std::unique_ptr<FileTransfer> prepareFileResponse(const HttpRequest &req, HttpResponse *resp)
+{
+    const std::shared_ptr<FileBody>& file = resp->fileBody();
+    off_t size = file->size();
+    resp->addHeader("Accept-Ranges", "bytes");
+
+    // 只有成功的GET响应才处理Range，其他情况按整个文件发送
+    std::vector<FileBody::ByteRange> ranges;
+    FileBody::RangeResult result = FileBody::kNoRange;
+    if (resp->getStatusCode() == HttpResponse::k200Ok 
+        && req.method() == HttpRequest::kGet 
+        && ifRangeMatches(req, *resp))
+    {
+        result = FileBody::parseRange(req.getHeader(HttpHeader::kRange), size, &ranges);
+    }
+
+    if (result == FileBody::kUnsatisfiable)
+    {
+        resp->setStatusLine(req.getVersion(), HttpResponse::k416RangeNotSatisfiable, "Range Not Satisfiable");
+        resp->addHeader("Content-Range", "bytes */" + std::to_string(size));
+        resp->setContentLength(0);
+        return nullptr;
+    }
+
+    auto transfer = std::make_unique<FileTransfer>(file, resp->closeConnection());
+    if (result == FileBody::kNoRange)
+    {
+        transfer->addSegment("", 0, size);
+    }
+    else if (ranges.size() == 1)
+    {
+        off_t first = ranges[0].first;
+        off_t last = ranges[0].second;
+        resp->setStatusLine(req.getVersion(), HttpResponse::k206PartialContent, "Partial Content");
+        resp->addHeader("Content-Range", "bytes " + std::to_string(first) + "-" 
+                        + std::to_string(last) + "/" + std::to_string(size));
+        transfer->addSegment("", first, last - first + 1);
+    }
+    else
+    {
+        // 多段范围按 multipart/byteranges 发送，每段带自己的 Content-Type 和 Content-Range
+        static std::atomic<uint64_t> boundaryCounter(0);
+        char boundary[32];
+        snprintf(boundary, sizeof boundary, "%020llu", 
+                 static_cast<unsigned long long>(++boundaryCounter));
+        std::string contentType = resp->getHeader("Content-Type");
+
+        for (const FileBody::ByteRange& range : ranges)
+        {
+            std::string prefix = "\r\n--";
+            prefix.append(boundary).append("\r\n");
+            if (!contentType.empty())
+            {
+                prefix.append("Content-Type: ").append(contentType).append("\r\n");
+            }
+            prefix.append("Content-Range: bytes ").append(std::to_string(range.first)).append("-")
+                  .append(std::to_string(range.second)).append("/").append(std::to_string(size))
+                  .append("\r\n\r\n");
+            transfer->addSegment(std::move(prefix), range.first, range.second - range.first + 1);
+        }
+        transfer->addSegment(std::string("\r\n--") + boundary + "--\r\n", 0, 0);
+
+        resp->setStatusLine(req.getVersion(), HttpResponse::k206PartialContent, "Partial Content");
+        resp->setContentType(std::string("multipart/byteranges; boundary=") + boundary);
+    }
+    resp->setContentLength(transfer->totalBytes());
+    return transfer;
+}
+
+} // namespace
+
 // 默认http回应函数
-void defaultHttpCallback(const HttpRequest &, HttpResponse *resp)
+void defaultHttpCallback(HttpRequest &, HttpResponse *resp)
 {
     resp->setStatusCode(HttpResponse::k404NotFound);
     resp->setStatusMessage("Not Found");
@@ -23,14 +241,63 @@ HttpServer::HttpServer(int port,
     , server_(&mainLoop_, listenAddr_, name, option)
     , useSSL_(useSSL)
     , httpCallback_(std::bind(&HttpServer::handleRequest, this, std::placeholders::_1, std::placeholders::_2))
+    , workerPool_("HttpWorkerPool")
+    , numWorkerThreads_(0)
+    , certificateCheckInterval_(0)
+    , numHandshakeThreads_(0)
+    , maxHandshakes_(0)
 {
+    workerPool_.setMaxQueueSize(kDefaultWorkerQueueSize);
     initialize();
 }
 
+HttpServer::~HttpServer()
+{
+    // 先停止握手线程，之后的握手步骤提交失败时在IO线程中执行；pool_本身由连接共同持有，连接全部销毁后才释放
+    if (handshakePool_)
+    {
+        handshakePool_->stop();
+    }
+    if (reloadThread_.joinable())
+    {
+        reloadThread_.join();
+    }
+}
+
 // 服务器运行函数
 void HttpServer::start()
 {
     LOG_WARN << "HttpServer[" << server_.name() << "] starts listening on" << server_.ipPort();
+    LOG_INFO << "HTTP parser uses " << scanner::implementation() << " scanner";
+    if (numWorkerThreads_ > 0)
+    {
+        workerPool_.start(numWorkerThreads_);
+    }
+    // 由主循环定时驱动会话过期清理，每次只推进一格时间轮
+    if (sessionManager_)
+    {
+        mainLoop_.runEvery(kSessionCleanInterval, [this]() {
+            sessionManager_->cleanExpiredSessions();
+        });
+    }
+    // 会话票据密钥由主循环定时轮换
+    if (sslCtx_ && sslCtx_->sessionTicketsEnabled() && sslCtx_->ticketRotationInterval() > 0)
+    {
+        mainLoop_.runEvery(sslCtx_->ticketRotationInterval(), [this]() {
+            sslCtx_->rotateTicketKeys();
+        });
+    }
+    // 证书重新加载由主循环检查，在后台线程中创建新的SSL_CTX，不阻塞IO线程
+    if (sslCtx_ && certificateCheckInterval_ > 0)
+    {
+        ::signal(SIGHUP, onSighup);
+        mainLoop_.runEvery(certificateCheckInterval_, [this]() { checkCertificates(); });
+    }
+    if (useSSL_ && (numHandshakeThreads_ > 0 || maxHandshakes_ > 0))
+    {
+        handshakePool_ = std::make_shared<ssl::HandshakePool>(numHandshakeThreads_, maxHandshakes_);
+        handshakePool_->start();
+    }
     server_.start();
     mainLoop_.loop();
 }
@@ -45,6 +312,29 @@ void HttpServer::initialize()
                   std::placeholders::_1,
                   std::placeholders::_2,
                   std::placeholders::_3));
+    server_.setWriteCompleteCallback(
+        std::bind(&HttpServer::onWriteComplete, this, std::placeholders::_1));
+    // 每个IO线程的Date缓存由本线程的定时器每秒刷新，序列化响应时不需要格式化时间
+    server_.setThreadInitCallback([this](muduo::net::EventLoop* loop) {
+        DateCache::refresh();
+        loop->runEvery(kDateRefreshInterval, []() { DateCache::refresh(); });
+        initConnectionTimer(loop);
+    });
+}
+
+void HttpServer::initConnectionTimer(muduo::net::EventLoop* loop)
+{
+    if (timeoutOptions_.idleTimeout <= 0 
+        && timeoutOptions_.headerTimeout <= 0 
+        && timeoutOptions_.requestTimeout <= 0)
+    {
+        return;
+    }
+    auto timer = std::make_unique<ConnectionTimer>(timeoutOptions_, &timeoutStats_);
+    t_connectionTimer = timer.get();
+    loop->runEvery(kTimeoutCheckInterval, [timer = timer.get()]() { timer->tick(); });
+    std::lock_guard<std::mutex> lock(timersMutex_);
+    connectionTimers_.push_back(std::move(timer));
 }
 
 void HttpServer::setSslConfig(const ssl::SslConfig& config)
@@ -60,26 +350,135 @@ void HttpServer::setSslConfig(const ssl::SslConfig& config)
     }
 }
 
+void HttpServer::addSslConfig(const ssl::SslConfig& config)
+{
+    if (!sslCtx_)
+    {
+        LOG_ERROR << "addSslConfig must be called after setSslConfig";
+        return;
+    }
+    if (!sslCtx_->addConfig(config))
+    {
+        LOG_ERROR << "Failed to load certificate " << config.getCertificateFile();
+        abort();
+    }
+}
+
+void HttpServer::checkCertificates()
+{
+    bool requested = g_certificateReloadRequested.exchange(false);
+    if (reloadingCertificates_ || !(requested || sslCtx_->certificatesChanged()))
+    {
+        return;
+    }
+    if (reloadThread_.joinable())
+    {
+        reloadThread_.join(); // 上一次加载已经结束
+    }
+    reloadingCertificates_ = true;
+    reloadThread_ = std::thread([this]() {
+        sslCtx_->reload();
+        reloadingCertificates_ = false;
+    });
+}
+
+void HttpServer::setBlockingRoute(HttpRequest::Method method, const std::string& path)
+{
+    router::Router::RouteKey key{method, path};
+    if (blockingRoutes_.find(key) == blockingRoutes_.end())
+    {
+        blockingRoutes_[key] = std::make_unique<worker::RouteStats>();
+    }
+}
+
+std::vector<HttpServer::RouteStatsSnapshot> HttpServer::getBlockingRouteStats() const
+{
+    std::vector<RouteStatsSnapshot> result;
+    result.reserve(blockingRoutes_.size());
+    for (const auto& [key, stats] : blockingRoutes_)
+    {
+        RouteStatsSnapshot snapshot;
+        snapshot.method = key.method;
+        snapshot.path = std::string(key.path);
+        snapshot.queueDepth = stats->queued.load();
+        snapshot.completed = stats->completed.load();
+        snapshot.rejected = stats->rejected.load();
+        snapshot.avgWaitUs = snapshot.completed > 0 
+            ? stats->totalWaitUs.load() / static_cast<int64_t>(snapshot.completed) : 0;
+        snapshot.maxWaitUs = stats->maxWaitUs.load();
+        result.push_back(std::move(snapshot));
+    }
+    return result;
+}
+
 void HttpServer::onConnection(const muduo::net::TcpConnectionPtr& conn)
 {
     if (conn->connected())
     {
+        if (++numConnections_ > limits_.maxConnections && limits_.maxConnections > 0)
+        {
+            --numConnections_;
+            rejectConnection(conn);
+            return;
+        }
+        // 握手的私钥运算开销远大于请求处理，超过并发握手上限时直接关闭，保护已建立连接的延迟
+        if (useSSL_ && handshakePool_ && !handshakePool_->tryAcquire())
+        {
+            --numConnections_;
+            LOG_WARN << "Too many TLS handshakes in flight, reject " << conn->peerAddress().toIpPort();
+            conn->forceClose();
+            return;
+        }
+        // 响应头和大响应体分两次写入，关闭Nagle避免响应体末尾的小分段等待对端的延迟ACK
+        conn->setTcpNoDelay(true);
+        conn->setHighWaterMarkCallback(
+            std::bind(&HttpServer::onHighWaterMark, this, std::placeholders::_1, std::placeholders::_2),
+            limits_.highWaterMark);
+        // 解析器、TLS引擎和统计信息都挂在连接自身上
+        auto state = std::make_shared<ConnectionState>(muduo::Timestamp::now());
+        state->context()->setBodyOptionsCallback(
+            std::bind(&HttpServer::bodyOptionsFor, this, std::placeholders::_1));
         if (useSSL_)
         {
-            auto sslConn = std::make_unique<ssl::SslConnection>(conn, sslCtx_.get());
-            sslConn->setMessageCallback(
-                std::bind(&HttpServer::onMessage, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-            sslConns_[conn] = std::move(sslConn);
-            sslConns_[conn]->startHandshake();
+            auto sslConn = std::make_unique<ssl::SslConnection>(conn, sslCtx_.get(), handshakePool_);
+            // 握手在握手线程中完成时，握手期间收到的请求由这里处理
+            sslConn->setHandshakeCallback([this](const muduo::net::TcpConnectionPtr& conn) {
+                if (ConnectionState* state = ConnectionState::get(conn))
+                {
+                    processDecrypted(conn, state, muduo::Timestamp::now());
+                }
+            });
+            state->setSslConnection(std::move(sslConn));
+            // 握手计入第一个请求的请求头接收时间
+            state->setRequestStartTime(state->stats().createTime);
+        }
+        conn->setContext(state);
+        if (t_connectionTimer)
+        {
+            t_connectionTimer->add(conn);
+        }
+        if (state->sslConnection())
+        {
+            state->sslConnection()->startHandshake();
         }
-        conn->setContext(HttpContext());
     }
     else 
     {
-        if (useSSL_)
+        // 被拒绝的连接没有连接状态，也没有计入连接数
+        ConnectionState* state = ConnectionState::get(conn);
+        if (!state)
+        {
+            return;
+        }
+        --numConnections_;
+        outputBytes_ -= static_cast<int64_t>(state->bufferedOutput());
+        // 唤醒等待中的流式响应生产者，让它发现连接已断开
+        if (state->responseStream())
         {
-            sslConns_.erase(conn);
+            state->responseStream()->onClose();
         }
+        // 连接状态(包括SslConnection)随连接断开立即释放
+        conn->setContext(boost::any());
     }
 }
 
@@ -87,98 +486,541 @@ void HttpServer::onMessage(const muduo::net::TcpConnectionPtr &conn,
                            muduo::net::Buffer *buf,
                            muduo::Timestamp receiveTime)
 {
-    try
+    ConnectionState* state = ConnectionState::get(conn);
+    if (!state)
     {
-        // 这层判断只是代表是否支持ssl
-        if (useSSL_)
+        buf->retrieveAll(); // 连接已断开或已被拒绝
+        return;
+    }
+    // 推迟空闲超时，超时检查时才使用它，这里只记录时间
+    state->stats().lastActiveTime = receiveTime;
+
+    // 这层判断只是代表是否支持ssl
+    if (ssl::SslConnection* sslConn = state->sslConnection())
+    {
+        // 1. SSL连接处理数据，解密本次收到的所有完整记录
+        sslConn->onRead(conn, buf, receiveTime);
+
+        // 2. 如果 SSL 握手还未完成，直接返回
+        if (!sslConn->isHandshakeCompleted())
         {
-            LOG_INFO << "onMessage useSSL_ is true";
-            // 1.查找对应的SSL连接
-            auto it = sslConns_.find(conn);
-            if (it != sslConns_.end())
-            {
-                LOG_INFO << "onMessage sslConns_ is not empty";
-                // 2. SSL连接处理数据
-                it->second->onRead(conn, buf, receiveTime);
+            return;
+        }
 
-                // 3. 如果 SSL 握手还未完成，直接返回
-                if (!it->second->isHandshakeCompleted())
-                {
-                    LOG_INFO << "onMessage sslConns_ is not empty";
-                    return;
-                }
+        // 3. 使用解密后的数据进行HTTP 处理
+        processDecrypted(conn, state, receiveTime);
+        return;
+    }
 
-                // 4. 从SSL连接的解密缓冲区获取数据
-                muduo::net::Buffer* decryptedBuf = it->second->getDecryptedBuffer();
-                if (decryptedBuf->readableBytes() == 0)
-                    return; // 没有解密后的数据
+    processRequests(conn, state, buf, receiveTime);
+}
 
-                // 5. 使用解密后的数据进行HTTP 处理
-                buf = decryptedBuf; // 将 buf 指向解密后的数据
-                LOG_INFO << "onMessage decryptedBuf is not empty";
-            }
+void HttpServer::processDecrypted(const muduo::net::TcpConnectionPtr &conn,
+                                  ConnectionState *state,
+                                  muduo::Timestamp receiveTime)
+{
+    muduo::net::Buffer* decryptedBuf = state->sslConnection()->getDecryptedBuffer();
+    if (decryptedBuf->readableBytes() == 0)
+    {
+        // 没有解密后的数据，握手刚完成时还没有开始接收请求
+        if (state->context()->expectingHeaders())
+        {
+            state->setRequestStartTime(muduo::Timestamp());
         }
+        return;
+    }
+    processRequests(conn, state, decryptedBuf, receiveTime);
+}
+
+void HttpServer::processRequests(const muduo::net::TcpConnectionPtr &conn,
+                                 ConnectionState *state,
+                                 muduo::net::Buffer *buf,
+                                 muduo::Timestamp receiveTime)
+{
+    OutputQueue output; // 本次读事件中所有请求的响应
+    bool close = false; // 是否需要在发送完响应后断开连接
+    ConnectionState::Stats& stats = state->stats();
+    size_t readable = buf->readableBytes();
+    try
+    {
         // HttpContext对象用于解析出buf中的请求报文，并把报文的关键信息封装到HttpRequest对象中
-        HttpContext *context = boost::any_cast<HttpContext>(conn->getMutableContext());
-        if (!context->parseRequest(buf, receiveTime)) // 解析一个http请求
+        HttpContext *context = state->context();
+        // 客户端可能在一个keep-alive连接上流水线发送多个请求，循环解析直到buf中不再有完整的请求
+        // 有请求在工作线程中执行时暂停解析，剩余数据留在buf中，等响应发出后再继续
+        // 正在发送文件响应时同样暂停，保证响应顺序
+        // 输出缓冲区积压过多时同样暂停，不再为读得慢的客户端生成更多响应
+        while (!close && state->readyForRequest() && buf->readableBytes() > 0)
         {
-            // 如果解析http报文过程中出错
-            conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-            conn->shutdown();
+            if (outputBlocked(conn, state))
+            {
+                pauseReading(conn, state);
+                break;
+            }
+            if (!context->parseRequest(buf, receiveTime)) // 解析一个http请求
+            {
+                // 如果解析http报文过程中出错，请求体超限时不再读取剩余数据
+                appendParseError(context->error(), &output);
+                close = true;
+                break;
+            }
+            // 数据不完整，等待更多数据到达
+            if (!context->gotAll())
+            {
+                break;
+            }
+            // 解析出一个完整的数据包才封装响应报文，响应按请求顺序追加到output中
+            worker::RouteStats* routeStats = findBlockingRoute(context->request());
+            if (routeStats)
+            {
+                close = dispatchToWorker(conn, state, routeStats, &output);
+            }
+            else
+            {
+                close = onRequest(state, context->request(), &output);
+            }
+            context->reset();
+            state->setRequestStartTime(muduo::Timestamp());
+            ++stats.requests;
         }
-        // 如果buf缓冲区中解析出一个完整的数据包才封装响应报文
-        if (context->gotAll())
+        // 剩下不完整的请求从现在开始计算请求头和整个请求的超时
+        if (!close && state->readyForRequest() && !state->requestStartTime().valid()
+            && (buf->readableBytes() > 0 || !context->expectingHeaders()))
         {
-            onRequest(conn, context->request());
-            context->reset();
+            state->setRequestStartTime(receiveTime);
         }
     }
     catch (const std::exception &e)
     {
         // 捕获异常，返回错误信息
         LOG_ERROR << "Exception in onMessage: " << e.what();
-        conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-        conn->shutdown();
+        appendParseError(HttpContext::kBadRequest, &output);
+        close = true;
     }
+    stats.bytesReceived += readable - buf->readableBytes();
+
+    // 本次读事件产生的所有响应合并为一次send
+    sendOutput(conn, state, &output, close);
 }
 
-void HttpServer::onRequest(const muduo::net::TcpConnectionPtr &conn, const HttpRequest &req)
+bool HttpServer::onRequest(ConnectionState *state, HttpRequest &req, OutputQueue *output)
 {
-    const std::string &connection = req.getHeader("Connection");
-    bool close = ((connection == "close") ||
-                  (req.getVersion() == "HTTP/1.0" && connection != "Keep-Alive"));
-    HttpResponse response(close);
+    HttpResponse response(closeRequested(req));
 
     // 根据请求报文信息来封装响应报文对象
     httpCallback_(req, &response); // 执行onHttpCallback函数
 
-    // 可以给response设置一个成员，判断是否请求的是文件，如果是文件设置为true，并且存在文件位置在这里send出去。
-    muduo::net::Buffer buf;
-    response.appendToBuffer(&buf);
-    // 打印完整的响应内容用于调试
-    LOG_INFO << "Sending response:\n" << buf.toStringPiece().as_string();
+    return writeResponse(state, req, &response, output);
+}
+
+bool HttpServer::writeResponse(ConnectionState *state,
+                               const HttpRequest &req,
+                               HttpResponse *response,
+                               OutputQueue *output)
+{
+    // HEAD请求的响应头与GET相同，但不发送响应体
+    bool withBody = req.method() != HttpRequest::kHead;
+
+    if (response->isFile() && response->getHeader("ETag").empty())
+    {
+        // 文件响应自动生成校验器，ETag由修改时间和大小组成
+        const std::shared_ptr<FileBody>& file = response->fileBody();
+        char etag[64];
+        snprintf(etag, sizeof etag, "\"%llx-%llx\"", 
+                 static_cast<unsigned long long>(file->lastModified()),
+                 static_cast<unsigned long long>(file->size()));
+        response->setETag(etag);
+        response->setLastModified(file->lastModified());
+    }
+    if (notModified(req, *response))
+    {
+        response->setStatusLine(req.getVersion(), HttpResponse::k304NotModified, "Not Modified");
+        response->clearBody();
+    }
+
+    if (response->isStream())
+    {
+        // 长度事先未知: HTTP/1.1分块发送，HTTP/1.0发送原始数据并以关闭连接表示结束
+        bool chunked = req.version() == HttpRequest::kHttp11;
+        if (chunked)
+        {
+            response->addHeader("Transfer-Encoding", "chunked");
+        }
+        else
+        {
+            response->setCloseConnection(true);
+        }
+        response->appendToBuffer(output->buffer(), false);
+        state->setResponseStream(
+            std::make_shared<ResponseStream>(response->streamCallback(), chunked, withBody));
+        return response->closeConnection();
+    }
+
+    if (response->isFile())
+    {
+        // 文件内容不进入output，由sendFileChunks在输出缓冲区空闲时按块读取发送
+        std::unique_ptr<FileTransfer> transfer = prepareFileResponse(req, response);
+        response->appendToBuffer(output->buffer(), false);
+        LOG_DEBUG << "Sending file " << response->fileBody()->path() << " status " << response->getStatusCode();
+        if (withBody && transfer && transfer->totalBytes() > 0)
+        {
+            state->setFileTransfer(std::move(transfer));
+        }
+        return response->closeConnection();
+    }
+
+    if (withBody && response->body().size() >= kLargeBodySize)
+    {
+        // 大响应体不拷贝进output，发送时直接交给连接
+        response->appendToBuffer(output->buffer(), false);
+        output->appendBody(response->releaseBody());
+    }
+    else
+    {
+        response->appendToBuffer(output->buffer(), withBody);
+    }
+    LOG_DEBUG << "Sending response " << response->getStatusCode() 
+              << " for " << muduo::StringPiece(req.path().data(), static_cast<int>(req.path().size()));
+
+    return response->closeConnection();
+}
 
-    conn->send(&buf);
+void HttpServer::sendOutput(const muduo::net::TcpConnectionPtr &conn,
+                            ConnectionState *state,
+                            OutputQueue *output,
+                            bool close)
+{
+    state->stats().bytesSent += output->readableBytes();
+    output->drain([&conn, state](const char *data, size_t len) {
+        state->send(conn, data, len);
+    });
+    updateBufferedOutput(conn, state);
+    // 文件发送完后再根据文件响应的close决定是否断开
+    if (state->fileTransfer())
+    {
+        sendFileChunks(conn, state);
+        return;
+    }
+    // 响应头已交给连接，开始推送流式响应体，流结束后再决定是否断开
+    if (ResponseStream* stream = state->responseStream())
+    {
+        if (!stream->started())
+        {
+            std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+            stream->start(conn, [this, weakConn, close]() {
+                onStreamDone(weakConn, close);
+            });
+        }
+        return;
+    }
     // 如果是短连接的话，返回响应报文后就断开连接
-    if (response.closeConnection())
+    if (close)
+    {
+        state->shutdown(conn);
+    }
+}
+
+void HttpServer::sendFileChunks(const muduo::net::TcpConnectionPtr &conn, ConnectionState *state)
+{
+    FileTransfer* transfer = state->fileTransfer();
+    if (!transfer)
+    {
+        return;
+    }
+
+    // 只在muduo输出缓冲区为空(内核发送缓冲区仍有空间)时读取下一块，
+    // 内核缓冲区写满后剩余数据留在输出缓冲区，等writeCompleteCallback再继续，内存中最多只有一块文件数据
+    // TLS连接的明文要到本轮事件循环结束时才加密发送，因此每次只读取一块
+    size_t sent = 0;
+    while (!transfer->done() 
+           && state->pendingOutput(conn) == 0 
+           && sent < kMaxFileBytesPerEvent)
+    {
+        muduo::net::Buffer chunk;
+        ssize_t n = transfer->fill(&chunk, kFileChunkSize);
+        if (n < 0)
+        {
+            // 已经发出的Content-Length无法满足，只能断开连接
+            state->setFileTransfer(nullptr);
+            conn->forceClose();
+            return;
+        }
+        sent += n;
+        state->stats().bytesSent += n;
+        state->send(conn, chunk.peek(), chunk.readableBytes());
+    }
+    updateBufferedOutput(conn, state);
+
+    if (!transfer->done())
+    {
+        return;
+    }
+    bool close = transfer->closeConnection();
+    state->setFileTransfer(nullptr);
+    if (close)
+    {
+        state->shutdown(conn);
+        return;
+    }
+    resumeRequests(conn, state);
+}
+
+void HttpServer::onWriteComplete(const muduo::net::TcpConnectionPtr &conn)
+{
+    ConnectionState* state = ConnectionState::get(conn);
+    if (!state)
+    {
+        return;
+    }
+    // 响应发送完，空闲超时从这里重新计算
+    state->stats().lastActiveTime = muduo::Timestamp::now();
+    updateBufferedOutput(conn, state);
+    if (state->fileTransfer())
+    {
+        sendFileChunks(conn, state);
+    }
+    else if (state->responseStream())
+    {
+        state->responseStream()->onWriteComplete();
+    }
+
+    // 输出缓冲区已排空，恢复读取并继续处理暂停时留下的请求
+    if (state->readPaused() && conn->connected())
+    {
+        state->setReadPaused(false);
+        conn->startRead();
+        if (state->readyForRequest())
+        {
+            resumeRequests(conn, state);
+        }
+    }
+}
+
+void HttpServer::onHighWaterMark(const muduo::net::TcpConnectionPtr &conn, size_t)
+{
+    ConnectionState* state = ConnectionState::get(conn);
+    if (!state)
+    {
+        return;
+    }
+    pauseReading(conn, state);
+    if (state->responseStream())
     {
-        conn->shutdown();
+        state->responseStream()->onHighWaterMark();
     }
 }
 
+void HttpServer::rejectConnection(const muduo::net::TcpConnectionPtr &conn)
+{
+    ++rejectedConnections_;
+    LOG_WARN << "Too many connections (" << limits_.maxConnections << "), reject " 
+             << conn->peerAddress().toIpPort();
+    if (!useSSL_)
+    {
+        conn->send(kServiceUnavailable, static_cast<int>(sizeof kServiceUnavailable - 1));
+    }
+    conn->shutdown();
+    conn->forceCloseWithDelay(kRejectCloseDelay);
+}
+
+bool HttpServer::outputBlocked(const muduo::net::TcpConnectionPtr &conn, const ConnectionState *state) const
+{
+    size_t buffered = state->pendingOutput(conn);
+    if (buffered >= limits_.highWaterMark)
+    {
+        return true;
+    }
+    // 总量超限时只暂停还有积压的连接，输出缓冲区为空的连接不会增加积压，照常处理
+    return limits_.maxOutputBytes > 0 
+        && buffered > 0 
+        && outputBytes_.load() >= static_cast<int64_t>(limits_.maxOutputBytes);
+}
+
+void HttpServer::pauseReading(const muduo::net::TcpConnectionPtr &conn, ConnectionState *state)
+{
+    if (!state->readPaused())
+    {
+        state->setReadPaused(true);
+        conn->stopRead();
+    }
+}
+
+void HttpServer::updateBufferedOutput(const muduo::net::TcpConnectionPtr &conn, ConnectionState *state)
+{
+    // 只在发送和写完成时采样，期间已写入内核的部分要等下次采样才扣除，总量偏大但不会偏小
+    size_t buffered = state->pendingOutput(conn);
+    outputBytes_ += static_cast<int64_t>(buffered) - static_cast<int64_t>(state->bufferedOutput());
+    state->setBufferedOutput(buffered);
+}
+
+void HttpServer::onStreamDone(const std::weak_ptr<muduo::net::TcpConnection> &weakConn, bool close)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    ConnectionState* state = conn ? ConnectionState::get(conn) : nullptr;
+    if (!state)
+    {
+        return;
+    }
+    state->setResponseStream(nullptr);
+    if (close)
+    {
+        state->shutdown(conn);
+        return;
+    }
+    resumeRequests(conn, state);
+}
+
+void HttpServer::resumeRequests(const muduo::net::TcpConnectionPtr &conn, ConnectionState *state)
+{
+    muduo::net::Buffer* input = state->sslConnection() 
+        ? state->sslConnection()->getDecryptedBuffer() : conn->inputBuffer();
+    if (input->readableBytes() > 0)
+    {
+        processRequests(conn, state, input, muduo::Timestamp::now());
+    }
+}
+
+void HttpServer::setBodyOptions(HttpRequest::Method method, const std::string& path, const BodyOptions& options)
+{
+    // 带 ':' 或 '*' 的路径模式和动态路由一样由路由树匹配
+    if (path.find_first_of(":*") != std::string::npos)
+    {
+        bodyOptionTrees_[method].insert(path, static_cast<int>(patternBodyOptions_.size()));
+        patternBodyOptions_.push_back(options);
+        return;
+    }
+    bodyOptions_[router::Router::RouteKey{method, path}] = options;
+}
+
+const BodyOptions& HttpServer::bodyOptionsFor(const HttpRequest &req) const
+{
+    if (!bodyOptions_.empty())
+    {
+        auto it = bodyOptions_.find(router::Router::RouteKey{req.method(), req.path()});
+        if (it != bodyOptions_.end())
+        {
+            return it->second;
+        }
+    }
+    auto treeIt = bodyOptionTrees_.find(req.method());
+    if (treeIt != bodyOptionTrees_.end())
+    {
+        // 路径参数在路由时才写入请求，这里只需要匹配结果
+        PathParams params;
+        int id = treeIt->second.match(req.path(), params);
+        if (id != router::RadixTree::kNoRoute)
+        {
+            return patternBodyOptions_[id];
+        }
+    }
+    return defaultBodyOptions_;
+}
+
+worker::RouteStats* HttpServer::findBlockingRoute(const HttpRequest &req)
+{
+    // 工作线程池未启动时阻塞路由也在IO线程中执行
+    if (blockingRoutes_.empty() || !workerPool_.started())
+    {
+        return nullptr;
+    }
+    auto it = blockingRoutes_.find(router::Router::RouteKey{req.method(), req.path()});
+    if (it == blockingRoutes_.end() && req.method() == HttpRequest::kHead)
+    {
+        // HEAD请求由GET路由处理，同样需要放到工作线程中
+        it = blockingRoutes_.find(router::Router::RouteKey{HttpRequest::kGet, req.path()});
+    }
+    return it != blockingRoutes_.end() ? it->second.get() : nullptr;
+}
+
+bool HttpServer::dispatchToWorker(const muduo::net::TcpConnectionPtr &conn,
+                                  ConnectionState *state,
+                                  worker::RouteStats *routeStats,
+                                  OutputQueue *output)
+{
+    // 把请求从解析器中取走，避免拷贝请求体
+    auto req = std::make_shared<HttpRequest>();
+    req->swap(state->context()->request());
+    bool close = closeRequested(*req);
+
+    muduo::net::EventLoop* loop = conn->getLoop();
+    std::weak_ptr<muduo::net::TcpConnection> weakConn(conn);
+    muduo::Timestamp enqueueTime = muduo::Timestamp::now();
+    ++routeStats->queued;
+    bool submitted = workerPool_.trySubmit(
+        [this, loop, weakConn, req, close, enqueueTime, routeStats]() {
+            --routeStats->queued;
+            routeStats->recordWait(muduo::Timestamp::now().microSecondsSinceEpoch() 
+                                   - enqueueTime.microSecondsSinceEpoch());
+
+            auto response = std::make_shared<HttpResponse>(close);
+            httpCallback_(*req, response.get());
+            ++routeStats->completed;
+
+            // 回到连接所属的IO线程序列化并发送响应
+            loop->runInLoop([this, weakConn, req, response]() {
+                onWorkerComplete(weakConn, req, response);
+            });
+        });
+
+    if (submitted)
+    {
+        state->setRequestInFlight(true);
+        return false;
+    }
+
+    // 队列已满，直接返回503
+    --routeStats->queued;
+    ++routeStats->rejected;
+    LOG_WARN << "Worker queue is full, reject " << muduo::StringPiece(req->path().data(), static_cast<int>(req->path().size()));
+    HttpResponse response(close);
+    response.setStatusLine(req->getVersion(), HttpResponse::k503ServiceUnavailable, "Service Unavailable");
+    response.setContentLength(0);
+    response.appendToBuffer(output->buffer());
+    return response.closeConnection();
+}
+
+void HttpServer::onWorkerComplete(const std::weak_ptr<muduo::net::TcpConnection> &weakConn,
+                                  const std::shared_ptr<HttpRequest> &req,
+                                  const std::shared_ptr<HttpResponse> &response)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || !conn->connected())
+    {
+        return; // 处理期间客户端已断开
+    }
+    ConnectionState* state = ConnectionState::get(conn);
+    if (!state)
+    {
+        return;
+    }
+
+    state->setRequestInFlight(false);
+    OutputQueue output;
+    bool close = writeResponse(state, *req, response.get(), &output);
+    // 文件和流式响应发送完成后由各自的发送流程继续处理后续请求
+    bool streaming = state->fileTransfer() != nullptr || state->responseStream() != nullptr;
+    sendOutput(conn, state, &output, close);
+    if (close || streaming)
+    {
+        return;
+    }
+
+    // 继续处理排队期间到达的流水线请求
+    resumeRequests(conn, state);
+}
+
 // 执行请求对应的路由处理函数
-void HttpServer::handleRequest(const HttpRequest &req, HttpResponse *resp)
+void HttpServer::handleRequest(HttpRequest &req, HttpResponse *resp)
 {
     try
     {
-        // 处理请求前的中间件
-        HttpRequest mutableReq = req;
-        middlewareChain_.processBefore(mutableReq);
+        // 处理请求前的中间件，中间件直接修改请求
+        middlewareChain_.processBefore(req);
 
         // 路由处理
-        if (!router_.route(mutableReq, resp))
+        if (!router_.route(req, resp))
         {
-            LOG_INFO << "请求的啥，url：" << req.method() << " " << req.path();
+            LOG_INFO << "请求的啥，url：" << req.method() << " " 
+                     << muduo::StringPiece(req.path().data(), static_cast<int>(req.path().size()));
             LOG_INFO << "未找到路由，返回404";
             resp->setStatusCode(HttpResponse::k404NotFound);
             resp->setStatusMessage("Not Found");
@@ -186,7 +1028,7 @@ void HttpServer::handleRequest(const HttpRequest &req, HttpResponse *resp)
         }
 
         // 处理响应后的中间件
-        middlewareChain_.processAfter(*resp);
+        middlewareChain_.processAfter(req, *resp);
     }
     catch (const HttpResponse& res) 
     {
@@ -199,6 +1041,12 @@ void HttpServer::handleRequest(const HttpRequest &req, HttpResponse *resp)
         resp->setStatusCode(HttpResponse::k500InternalServerError);
         resp->setBody(e.what());
     }
+
+    // 请求结束，把本次请求中修改过的会话统一写回存储
+    if (sessionManager_)
+    {
+        sessionManager_->flushSessions();
+    }
 }
 
 } // namespace http
\ No newline at end of file
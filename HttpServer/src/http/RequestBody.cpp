@@ -0,0 +1,63 @@
+#include "../../include/http/RequestBody.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+std::unique_ptr<BodyFile> BodyFile::create(const std::string& dir)
+{
+    std::string path = dir + "/http-body-XXXXXX";
+    int fd = ::mkostemp(&path[0], O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "BodyFile create in " << dir << " failed";
+        return nullptr;
+    }
+    ::unlink(path.c_str());
+    return std::unique_ptr<BodyFile>(new BodyFile(fd));
+}
+
+BodyFile::~BodyFile()
+{
+    ::close(fd_);
+}
+
+bool BodyFile::append(const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::pwrite(fd_, data, len, static_cast<off_t>(size_));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_SYSERR << "BodyFile write failed";
+            return false;
+        }
+        data += n;
+        len -= n;
+        size_ += n;
+    }
+    return true;
+}
+
+ssize_t BodyFile::read(off_t offset, char* buf, size_t len) const
+{
+    ssize_t n;
+    do
+    {
+        n = ::pread(fd_, buf, len, offset);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+} // namespace http
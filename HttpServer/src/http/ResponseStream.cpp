@@ -0,0 +1,179 @@
+#include "../../include/http/ResponseStream.h"
+#include "../../include/http/ConnectionState.h"
+
+#include <cstdio>
+
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+ResponseStream::ResponseStream(StartCallback start, bool chunked, bool withBody)
+    : start_(std::move(start))
+    , loop_(nullptr)
+    , chunked_(chunked)
+    , withBody_(withBody)
+    , closed_(false)
+    , finished_(false)
+    , highWater_(false)
+    , waiting_(false)
+    , pendingBytes_(0)
+{
+}
+
+bool ResponseStream::write(const char* data, size_t len)
+{
+    if (closed_ || finished_)
+    {
+        return false;
+    }
+    if (!withBody_ || len == 0)
+    {
+        return true; // 长度为0的块表示结束，不能发送
+    }
+
+    // 块头、数据和块尾拼成一次发送
+    std::string chunk;
+    if (chunked_)
+    {
+        char head[32];
+        int n = snprintf(head, sizeof head, "%zx\r\n", len);
+        chunk.reserve(n + len + 2);
+        chunk.append(head, n);
+        chunk.append(data, len);
+        chunk.append("\r\n", 2);
+    }
+    else
+    {
+        chunk.assign(data, len);
+    }
+
+    pendingBytes_ += chunk.size();
+    auto self = shared_from_this();
+    loop_->runInLoop([self, chunk = std::move(chunk)]() {
+        self->sendInLoop(chunk);
+    });
+    return true;
+}
+
+void ResponseStream::finish()
+{
+    if (closed_ || finished_.exchange(true))
+    {
+        return;
+    }
+    auto self = shared_from_this();
+    loop_->runInLoop([self]() {
+        self->finishInLoop();
+    });
+}
+
+bool ResponseStream::paused()
+{
+    // 先登记等待再检查条件，避免检查之后、登记之前输出缓冲区恰好排空而错过resume
+    waiting_ = true;
+    bool paused = highWater_ || pendingBytes_ >= kMaxPendingBytes;
+    if (!paused)
+    {
+        waiting_ = false;
+    }
+    return paused;
+}
+
+void ResponseStream::setResumeCallback(ResumeCallback cb)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    resume_ = std::move(cb);
+}
+
+void ResponseStream::start(const muduo::net::TcpConnectionPtr& conn, DoneCallback done)
+{
+    conn_ = conn;
+    loop_ = conn->getLoop();
+    done_ = std::move(done);
+    StartCallback start;
+    start.swap(start_);
+    if (start)
+    {
+        start(shared_from_this());
+    }
+}
+
+void ResponseStream::onHighWaterMark()
+{
+    highWater_ = true;
+}
+
+void ResponseStream::onWriteComplete()
+{
+    highWater_ = false;
+    if (waiting_.exchange(false))
+    {
+        resume();
+    }
+}
+
+void ResponseStream::onClose()
+{
+    if (closed_.exchange(true))
+    {
+        return;
+    }
+    // 唤醒等待中的生产者，让它发现连接已断开
+    resume();
+    std::lock_guard<std::mutex> lock(mutex_);
+    resume_ = nullptr; // 回调通常持有本对象，清空以打破引用环
+}
+
+void ResponseStream::sendInLoop(const std::string& data)
+{
+    pendingBytes_ -= data.size();
+    muduo::net::TcpConnectionPtr conn = conn_.lock();
+    ConnectionState* state = conn && conn->connected() ? ConnectionState::get(conn) : nullptr;
+    if (!state)
+    {
+        onClose();
+        return;
+    }
+    state->send(conn, data.data(), data.size());
+}
+
+void ResponseStream::finishInLoop()
+{
+    muduo::net::TcpConnectionPtr conn = conn_.lock();
+    ConnectionState* state = conn && conn->connected() ? ConnectionState::get(conn) : nullptr;
+    if (!state)
+    {
+        onClose();
+        return;
+    }
+    if (chunked_ && withBody_)
+    {
+        state->send(conn, "0\r\n\r\n", 5);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resume_ = nullptr;
+    }
+    DoneCallback done;
+    done.swap(done_);
+    if (done)
+    {
+        done();
+    }
+}
+
+void ResponseStream::resume()
+{
+    ResumeCallback cb;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cb = resume_;
+    }
+    if (cb)
+    {
+        cb();
+    }
+}
+
+} // namespace http
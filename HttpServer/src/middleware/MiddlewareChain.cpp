@@ -19,7 +19,7 @@ void MiddlewareChain::processBefore(HttpRequest &request)
     }
 }
 
-void MiddlewareChain::processAfter(HttpResponse &response)
+void MiddlewareChain::processAfter(const HttpRequest &request, HttpResponse &response)
 {
     try
     {
@@ -28,7 +28,7 @@ void MiddlewareChain::processAfter(HttpResponse &response)
         {
             if (*it)
             { // 添加空指针检查
-                (*it)->after(response);
+                (*it)->after(request, response);
             }
         }
     }
@@ -0,0 +1,302 @@
+#include "../../../include/middleware/compression/CompressionMiddleware.h"
+
+#include <strings.h>
+
+#include <zlib.h>
+#ifdef HTTP_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+namespace middleware
+{
+
+namespace
+{
+
+const char* encodingName(CompressionMiddleware::Encoding encoding)
+{
+    switch (encoding)
+    {
+    case CompressionMiddleware::kBrotli:  return "br";
+    case CompressionMiddleware::kGzip:    return "gzip";
+    case CompressionMiddleware::kDeflate: return "deflate";
+    default:                              return "identity";
+    }
+}
+
+// gzip 和 deflate 只是外层封装不同: windowBits 加16输出gzip头，否则输出zlib头
+std::string zlibCompress(const std::string& data, int level, bool gzip)
+{
+    z_stream zs = {};
+    if (deflateInit2(&zs, level, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return std::string();
+    }
+
+    std::string out(deflateBound(&zs, data.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    int ret = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END ? out : std::string();
+}
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+    {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+    {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && ::strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+// 解析 q 值，格式为 "0"、"1" 或 "0.xyz"，不合法时按0处理
+double parseQValue(std::string_view str)
+{
+    str = trim(str);
+    if (str.empty() || (str[0] != '0' && str[0] != '1'))
+    {
+        return 0;
+    }
+    double q = str[0] - '0';
+    double scale = 0.1;
+    for (size_t i = 2; i < str.size() && i < 5 && str[1] == '.'; ++i)
+    {
+        if (str[i] < '0' || str[i] > '9')
+        {
+            break;
+        }
+        q += (str[i] - '0') * scale;
+        scale /= 10;
+    }
+    return q > 1 ? 1 : q;
+}
+
+// 在ETag的结束引号前加上编码后缀，使不同编码的表示有不同的校验器
+std::string etagWithEncoding(const std::string& etag, const char* name)
+{
+    if (etag.size() < 2 || etag.back() != '"')
+    {
+        return etag;
+    }
+    std::string result(etag, 0, etag.size() - 1);
+    result.append("-").append(name).append("\"");
+    return result;
+}
+
+} // namespace
+
+CompressionMiddleware::CompressionMiddleware(const CompressionConfig& config)
+    : config_(config)
+    , types_(config.compressibleTypes.begin(), config.compressibleTypes.end())
+    , cacheBytes_(0)
+{
+}
+
+void CompressionMiddleware::after(const HttpRequest& request, HttpResponse& response)
+{
+    if (!isCompressible(response))
+    {
+        return;
+    }
+
+    // 无论这次是否压缩，响应内容都随 Accept-Encoding 变化，需要告知缓存代理
+    std::string vary = response.getHeader("Vary");
+    response.addHeader("Vary", vary.empty() ? "Accept-Encoding" : vary + ", Accept-Encoding");
+
+    Encoding encoding = negotiate(request.getHeader(HttpHeader::kAcceptEncoding));
+    if (encoding == kIdentity)
+    {
+        return;
+    }
+
+    const std::string& body = response.body();
+    std::string etag = response.getHeader("ETag");
+    std::shared_ptr<const std::string> compressed;
+    if (!etag.empty())
+    {
+        // 带ETag的是静态资源，内容由ETag唯一确定，压缩结果可以复用
+        // 未命中时在当前线程(可能是IO线程)压缩，使用配置的级别，不用最高压缩率
+        std::string key = etag + encodingName(encoding);
+        compressed = getCached(key);
+        if (!compressed)
+        {
+            compressed = std::make_shared<const std::string>(compress(encoding, body));
+            putCached(key, compressed);
+        }
+    }
+    else
+    {
+        compressed = std::make_shared<const std::string>(compress(encoding, body));
+    }
+
+    // 压缩失败或没有变小时按原样发送
+    if (compressed->empty() || compressed->size() >= body.size())
+    {
+        return;
+    }
+
+    response.addHeader("Content-Encoding", encodingName(encoding));
+    response.setContentLength(compressed->size());
+    if (!etag.empty())
+    {
+        response.setETag(etagWithEncoding(etag, encodingName(encoding)));
+    }
+    response.setBody(std::move(compressed));
+}
+
+CompressionMiddleware::Encoding CompressionMiddleware::negotiate(std::string_view acceptEncoding)
+{
+    // 按 q 值选择，q 相同时按 br > gzip > deflate 的顺序
+    double qBrotli = -1, qGzip = -1, qDeflate = -1, qAny = -1;
+    while (!acceptEncoding.empty())
+    {
+        size_t comma = acceptEncoding.find(',');
+        std::string_view item = acceptEncoding.substr(0, comma);
+        acceptEncoding = comma == std::string_view::npos
+            ? std::string_view() : acceptEncoding.substr(comma + 1);
+
+        double q = 1.0;
+        size_t semicolon = item.find(';');
+        if (semicolon != std::string_view::npos)
+        {
+            size_t qPos = item.find("q=", semicolon);
+            if (qPos != std::string_view::npos)
+            {
+                q = parseQValue(item.substr(qPos + 2));
+            }
+            item = item.substr(0, semicolon);
+        }
+        item = trim(item);
+
+        if (equalsIgnoreCase(item, "br")) qBrotli = q;
+        else if (equalsIgnoreCase(item, "gzip")) qGzip = q;
+        else if (equalsIgnoreCase(item, "deflate")) qDeflate = q;
+        else if (item == "*") qAny = q;
+    }
+
+    // 没有显式列出的编码使用 "*" 的 q 值
+    if (qBrotli < 0) qBrotli = qAny;
+    if (qGzip < 0) qGzip = qAny;
+    if (qDeflate < 0) qDeflate = qAny;
+#ifndef HTTP_HAVE_BROTLI
+    qBrotli = -1;
+#endif
+
+    Encoding best = kIdentity;
+    double bestQ = 0;
+    if (qBrotli > bestQ) { best = kBrotli; bestQ = qBrotli; }
+    if (qGzip > bestQ) { best = kGzip; bestQ = qGzip; }
+    if (qDeflate > bestQ) { best = kDeflate; bestQ = qDeflate; }
+    return best;
+}
+
+std::string CompressionMiddleware::compress(Encoding encoding, const std::string& data) const
+{
+    switch (encoding)
+    {
+    case kGzip:
+        return zlibCompress(data, config_.gzipLevel, true);
+    case kDeflate:
+        return zlibCompress(data, config_.gzipLevel, false);
+#ifdef HTTP_HAVE_BROTLI
+    case kBrotli:
+    {
+        size_t outSize = BrotliEncoderMaxCompressedSize(data.size());
+        if (outSize == 0)
+        {
+            return std::string();
+        }
+        std::string out(outSize, '\0');
+        if (!BrotliEncoderCompress(config_.brotliQuality,
+                                   BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                   data.size(), reinterpret_cast<const uint8_t*>(data.data()),
+                                   &outSize, reinterpret_cast<uint8_t*>(&out[0])))
+        {
+            return std::string();
+        }
+        out.resize(outSize);
+        return out;
+    }
+#endif
+    default:
+        return std::string();
+    }
+}
+
+bool CompressionMiddleware::isCompressible(const HttpResponse& response) const
+{
+    // 文件响应按块发送，已编码的响应不再重复压缩
+    if (response.getStatusCode() != HttpResponse::k200Ok
+        || response.isFile()
+        || !response.getHeader("Content-Encoding").empty()
+        || response.body().size() < config_.minSize)
+    {
+        return false;
+    }
+
+    std::string contentType = response.getHeader("Content-Type");
+    size_t semicolon = contentType.find(';');
+    if (semicolon != std::string::npos)
+    {
+        contentType.resize(semicolon);
+    }
+    return types_.count(contentType) > 0;
+}
+
+std::shared_ptr<const std::string> CompressionMiddleware::getCached(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_.find(key);
+    if (it == cache_.end())
+    {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+void CompressionMiddleware::putCached(const std::string& key, std::shared_ptr<const std::string> data)
+{
+    if (data->size() > config_.maxCacheBytes)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cache_.count(key) > 0)
+    {
+        return; // 其他线程已经压缩过
+    }
+    cacheBytes_ += data->size();
+    lru_.emplace_front(key, std::move(data));
+    cache_[key] = lru_.begin();
+
+    // 淘汰最久未使用的条目，文件更新后旧ETag的结果也会由此淘汰
+    while (cacheBytes_ > config_.maxCacheBytes)
+    {
+        cacheBytes_ -= lru_.back().second->size();
+        cache_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    LOG_DEBUG << "CompressionMiddleware cached " << key << ", total " << cacheBytes_ << " bytes";
+}
+
+} // namespace middleware
+} // namespace http
@@ -0,0 +1,202 @@
+#include "../../include/router/RadixTree.h"
+
+#include <stdexcept>
+
+namespace http
+{
+namespace router
+{
+
+RadixTree::RadixTree()
+    : root_(std::make_unique<Node>())
+    , size_(0)
+{
+}
+
+RadixTree::~RadixTree() = default;
+
+void RadixTree::insert(const std::string& pattern, int routeId)
+{
+    if (pattern.empty() || pattern[0] != '/')
+    {
+        throw std::invalid_argument("route pattern must start with '/': " + pattern);
+    }
+
+    // 把模式拆分为 静态片段 / :参数 / *通配符 依次插入
+    Node* node = root_.get();
+    std::string_view rest(pattern);
+    while (!rest.empty())
+    {
+        size_t pos = rest.find_first_of(":*");
+        if (pos != 0)
+        {
+            node = insertStatic(node, rest.substr(0, pos));
+            if (pos == std::string_view::npos)
+            {
+                break;
+            }
+            rest.remove_prefix(pos);
+        }
+
+        // 参数必须占据完整的路径段
+        if (node->type == Node::kStatic && (node->text.empty() || node->text.back() != '/'))
+        {
+            throw std::invalid_argument("path parameter must follow '/': " + pattern);
+        }
+        Node::Type type = rest[0] == ':' ? Node::kParam : Node::kWildcard;
+        size_t end = rest.find('/');
+        std::string_view name = rest.substr(1, end == std::string_view::npos ? end : end - 1);
+        if (type == Node::kWildcard && end != std::string_view::npos)
+        {
+            throw std::invalid_argument("wildcard must be the last segment: " + pattern);
+        }
+        node = insertParam(node, type, name, pattern);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end);
+    }
+
+    if (node->routeId == kNoRoute)
+    {
+        ++size_;
+    }
+    node->routeId = routeId; // 重复注册时覆盖，与精准匹配路由的行为一致
+}
+
+RadixTree::Node* RadixTree::insertStatic(Node* node, std::string_view text)
+{
+    while (!text.empty())
+    {
+        size_t idx = node->indices.find(text[0]);
+        if (idx == std::string::npos)
+        {
+            // 没有公共前缀，新建子节点
+            auto child = std::make_unique<Node>();
+            child->text.assign(text.data(), text.size());
+            node->indices.push_back(text[0]);
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+
+        Node* child = node->children[idx].get();
+        size_t common = 0;
+        size_t maxCommon = std::min(child->text.size(), text.size());
+        while (common < maxCommon && child->text[common] == text[common])
+        {
+            ++common;
+        }
+
+        if (common < child->text.size())
+        {
+            // 分裂子节点: child 变为公共前缀，原来的剩余部分下沉为它的子节点
+            auto tail = std::make_unique<Node>();
+            tail->text = child->text.substr(common);
+            tail->indices.swap(child->indices);
+            tail->children.swap(child->children);
+            tail->paramChild = std::move(child->paramChild);
+            tail->wildcardChild = std::move(child->wildcardChild);
+            tail->routeId = child->routeId;
+
+            child->text.resize(common);
+            child->routeId = kNoRoute;
+            child->indices.assign(1, tail->text[0]);
+            child->children.push_back(std::move(tail));
+        }
+
+        node = child;
+        text.remove_prefix(common);
+    }
+    return node;
+}
+
+RadixTree::Node* RadixTree::insertParam(Node* node, Node::Type type, std::string_view name, const std::string& pattern)
+{
+    if (name.empty())
+    {
+        throw std::invalid_argument("path parameter must have a name: " + pattern);
+    }
+
+    std::unique_ptr<Node>& slot = type == Node::kParam ? node->paramChild : node->wildcardChild;
+    if (!slot)
+    {
+        slot = std::make_unique<Node>();
+        slot->type = type;
+        slot->text.assign(name.data(), name.size());
+    }
+    else if (slot->text != name)
+    {
+        // 同一位置的参数名必须一致，否则匹配结果有歧义
+        throw std::invalid_argument("conflicting parameter name '" + std::string(name)
+                                    + "' with ':" + slot->text + "' in " + pattern);
+    }
+    return slot.get();
+}
+
+int RadixTree::match(std::string_view path, PathParams& params) const
+{
+    if (size_ == 0)
+    {
+        return kNoRoute;
+    }
+    return matchChildren(root_.get(), path, params);
+}
+
+// node 自身已经匹配，继续用剩余的 path 匹配它的子节点
+int RadixTree::matchChildren(const Node* node, std::string_view path, PathParams& params) const
+{
+    if (path.empty())
+    {
+        if (node->routeId != kNoRoute)
+        {
+            return node->routeId;
+        }
+        // 通配符允许匹配空串
+        if (node->wildcardChild && node->wildcardChild->routeId != kNoRoute)
+        {
+            params.emplace_back(node->wildcardChild->text, path);
+            return node->wildcardChild->routeId;
+        }
+        return kNoRoute;
+    }
+
+    // 1. 静态子节点，同一首字符最多只有一个
+    size_t idx = node->indices.find(path[0]);
+    if (idx != std::string::npos)
+    {
+        const Node* child = node->children[idx].get();
+        if (path.compare(0, child->text.size(), child->text) == 0)
+        {
+            int id = matchChildren(child, path.substr(child->text.size()), params);
+            if (id != kNoRoute)
+            {
+                return id;
+            }
+        }
+    }
+
+    // 2. 命名参数，匹配到下一个 '/' 为止
+    if (node->paramChild)
+    {
+        size_t end = path.find('/');
+        std::string_view value = path.substr(0, end);
+        if (!value.empty())
+        {
+            params.emplace_back(node->paramChild->text, value);
+            int id = matchChildren(node->paramChild.get(), path.substr(value.size()), params);
+            if (id != kNoRoute)
+            {
+                return id;
+            }
+            params.pop_back(); // 回溯
+        }
+    }
+
+    // 3. 通配符，匹配剩余全部路径
+    if (node->wildcardChild && node->wildcardChild->routeId != kNoRoute)
+    {
+        params.emplace_back(node->wildcardChild->text, path);
+        return node->wildcardChild->routeId;
+    }
+    return kNoRoute;
+}
+
+} // namespace router
+} // namespace http
@@ -18,9 +18,31 @@ void Router::registerCallback(HttpRequest::Method method, const std::string &pat
     callbacks_[key] = std::move(callback);
 }
 
-bool Router::route(const HttpRequest &req, HttpResponse *resp)
+void Router::addRoute(HttpRequest::Method method, const std::string &pattern, HandlerPtr handler)
 {
-    RouteKey key{req.method(), req.path()};
+    trees_[method].insert(pattern, static_cast<int>(dynamicRoutes_.size()));
+    dynamicRoutes_.push_back(DynamicRoute{std::move(handler), nullptr});
+}
+
+void Router::addRoute(HttpRequest::Method method, const std::string &pattern, const HandlerCallback &callback)
+{
+    trees_[method].insert(pattern, static_cast<int>(dynamicRoutes_.size()));
+    dynamicRoutes_.push_back(DynamicRoute{nullptr, callback});
+}
+
+bool Router::route(HttpRequest &req, HttpResponse *resp)
+{
+    if (dispatch(req.method(), req, resp))
+    {
+        return true;
+    }
+    // 没有单独注册HEAD路由时使用GET路由处理，响应体在发送时丢弃
+    return req.method() == HttpRequest::kHead && dispatch(HttpRequest::kGet, req, resp);
+}
+
+bool Router::dispatch(HttpRequest::Method method, HttpRequest &req, HttpResponse *resp)
+{
+    RouteKey key{method, req.path()};
 
     // 查找处理器
     auto handlerIt = handlers_.find(key);
@@ -38,35 +60,50 @@ bool Router::route(const HttpRequest &req, HttpResponse *resp)
         return true;
     }
 
-    // 查找动态路由处理器
-    for (const auto &[method, pathRegex, handler] : regexHandlers_)
+    // 路由树匹配动态路由，路径参数以视图形式写入请求，不拷贝请求
+    auto treeIt = trees_.find(method);
+    if (treeIt != trees_.end())
+    {
+        int id = treeIt->second.match(req.path(), req.pathParams());
+        if (id != RadixTree::kNoRoute)
+        {
+            const DynamicRoute &dynamicRoute = dynamicRoutes_[id];
+            if (dynamicRoute.handler_)
+            {
+                dynamicRoute.handler_->handle(req, resp);
+            }
+            else
+            {
+                dynamicRoute.callback_(req, resp);
+            }
+            return true;
+        }
+    }
+
+    // 查找正则动态路由(后备)，直接在请求路径上匹配，参数写入请求本身
+    if (regexHandlers_.empty() && regexCallbacks_.empty())
+    {
+        return false;
+    }
+    std::string_view path = req.path();
+    std::cmatch match;
+    for (const auto &[routeMethod, pathRegex, handler] : regexHandlers_)
     {
-        std::smatch match;
-        std::string pathStr(req.path());
         // 如果方法匹配并且动态路由匹配，则执行处理器
-        if (method == req.method() && std::regex_match(pathStr, match, pathRegex))
+        if (routeMethod == method && std::regex_match(path.data(), path.data() + path.size(), match, pathRegex))
         {
-            // Extract path parameters and add them to the request
-            HttpRequest newReq(req); // 因为这里需要用这一次所以是可以改的
-            extractPathParameters(match, newReq);
-            
-            handler->handle(newReq, resp);
+            extractPathParameters(match, req);
+            handler->handle(req, resp);
             return true;
         }
     }
 
-    // 查找动态路由回调函数
-    for (const auto &[method, pathRegex, callback] : regexCallbacks_)
+    for (const auto &[routeMethod, pathRegex, callback] : regexCallbacks_)
     {
-        std::smatch match;
-        std::string pathStr(req.path());
         // 如果方法匹配并且动态路由匹配，则执行回调函数
-        if (method == req.method() && std::regex_match(pathStr, match, pathRegex))
+        if (routeMethod == method && std::regex_match(path.data(), path.data() + path.size(), match, pathRegex))
         {
-             // Extract path parameters and add them to the request
-            HttpRequest newReq(req); // 因为这里需要用这一次所以是可以改的
-            extractPathParameters(match, newReq);
-
+            extractPathParameters(match, req);
             callback(req, resp);
             return true;
         }
@@ -7,8 +7,22 @@ namespace http
 namespace session
 {
 
+namespace
+{
+
+int64_t nowSeconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 Session::Session(const std::string& sessionId, SessionManager* sessionManager, int maxAge)
     : sessionId_(sessionId)
+    , expiryTime_(0)
+    , savedExpiryTime_(0)
+    , dirty_(true) // 新建的会话还没有写入存储
     , maxAge_(maxAge)
     , sessionManager_(sessionManager)
 {
@@ -18,29 +32,43 @@ Session::Session(const std::string& sessionId, SessionManager* sessionManager, i
 // 检查会话是否已过期
 bool Session::isExpired() const
 {
-    return std::chrono::system_clock::now() > expiryTime_;
+    return nowSeconds() > getExpiryTime();
 }
 
 // 刷新会话的过期时间
 void Session::refresh()
 {
-    expiryTime_ = std::chrono::system_clock::now() + std::chrono::seconds(maxAge_);
+    int64_t expiryTime = nowSeconds() + maxAge_;
+    expiryTime_.store(expiryTime, std::memory_order_relaxed);
+    // 每次请求都会刷新过期时间，只有比存储中的过期时间推后超过一半有效期时才需要写回，
+    // 避免持久化存储在每个请求上都写一次
+    if (expiryTime - savedExpiryTime_.load(std::memory_order_relaxed) > maxAge_ / 2)
+    {
+        markDirty();
+    }
+}
+
+void Session::markClean()
+{
+    savedExpiryTime_.store(getExpiryTime(), std::memory_order_relaxed);
+    dirty_.store(false, std::memory_order_release);
 }
 
 // 设置会话数据
 void Session::setValue(const std::string& key, const std::string& value)
 {
-    data_[key] = value;
-    // 如果设置了manager，自动保存更改
-    if (sessionManager_)
     {
-        sessionManager_->updateSession(shared_from_this());
+        std::lock_guard<std::mutex> lock(mutex_);
+        data_[key] = value;
     }
+    // 只做标记，请求结束时统一写回存储
+    markDirty();
 }
 
 // 获取会话数据
 std::string Session::getValue(const std::string& key) const
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     auto it = data_.find(key);
     return it != data_.end() ? it->second : std::string();
 }
@@ -48,13 +76,21 @@ std::string Session::getValue(const std::string& key) const
 // 删除会话数据
 void Session::remove(const std::string& key)
 {
-    data_.erase(key);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        data_.erase(key);
+    }
+    markDirty();
 }
 
 // 清空会话数据
 void Session::clear()
 {
-    data_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        data_.clear();
+    }
+    markDirty();
 }
 
 } // namespace session
@@ -1,4 +1,5 @@
 #include"../include/session/SessionManager.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -8,6 +9,15 @@ namespace http
 namespace session
 {
 
+namespace
+{
+
+// 当前线程正在处理的请求中获取过的会话
+// 一个请求从中间件到处理器都在同一个线程(IO线程或工作线程)中执行，请求结束时由flushSessions清空
+thread_local std::vector<std::shared_ptr<Session>> t_requestSessions;
+
+} // namespace
+
 // 初始化会话管理器，设置会话存储对象和随机数生成器
 SessionManager::SessionManager(std::unique_ptr<SessionStorage> storage)
     : storage_(std::move(storage)) 
@@ -38,15 +48,32 @@ std::shared_ptr<Session> SessionManager::getSession(const HttpRequest& req, Http
     }
 
     session->refresh();
-    storage_->save(session);  // 这里可能有问题，需要确保正确保存会话
+    // 不在这里保存，请求结束时如果会话有修改再统一写回
+    if (std::find(t_requestSessions.begin(), t_requestSessions.end(), session) == t_requestSessions.end())
+    {
+        t_requestSessions.push_back(session);
+    }
     return session;
 }
 
+void SessionManager::flushSessions()
+{
+    for (const auto& session : t_requestSessions)
+    {
+        if (session->getManager() == this && session->isDirty())
+        {
+            updateSession(session);
+        }
+    }
+    t_requestSessions.clear();
+}
+
 // 生成唯一的会话标识符，确保会话的唯一性和安全性
 std::string SessionManager::generateSessionId()
 {
     std::stringstream ss;
     std::uniform_int_distribution<> dist(0, 15);
+    std::lock_guard<std::mutex> lock(rngMutex_);
 
     // 生成32个字符的会话ID，每个字符是一个十六进制数字
     for (int i = 0; i < 32; ++i)
@@ -59,34 +86,40 @@ std::string SessionManager::generateSessionId()
 void SessionManager::destroySession(const std::string& sessionId)
 {
     storage_->remove(sessionId);
+    // 已销毁的会话不能在请求结束时被重新写回
+    t_requestSessions.erase(
+        std::remove_if(t_requestSessions.begin(), t_requestSessions.end(),
+                       [&sessionId](const std::shared_ptr<Session>& session) {
+                           return session->getId() == sessionId;
+                       }),
+        t_requestSessions.end());
 }
 
 void SessionManager::cleanExpiredSessions()
 {
-    // 注意：这个实现依赖于具体的存储实现
-    // 对于内存存储，可以在加载时检查是否过期
-    // 对于其他存储的实现，可能需要定期清理过期会话
+    // 具体的清理方式依赖于存储实现，内存存储按时间轮增量清理
+    storage_->cleanExpired();
 }
 
 std::string SessionManager::getSessionIdFromCookie(const HttpRequest& req)
 {
     std::string sessionId;
-    std::string cookie = req.getHeader("Cookie");
+    std::string_view cookie = req.getHeader(HttpHeader::kCookie);
 
     if (!cookie.empty())
     {
         size_t pos = cookie.find("sessionId=");
-        if (pos != std::string::npos)
+        if (pos != std::string_view::npos)
         {
             pos += 10; // 跳过"sessionId="
             size_t end = cookie.find(';', pos);
-            if (end != std::string::npos)
+            if (end != std::string_view::npos)
             {
-                sessionId = cookie.substr(pos, end - pos);
+                sessionId.assign(cookie.substr(pos, end - pos));
             }
             else
             {
-                sessionId = cookie.substr(pos);
+                sessionId.assign(cookie.substr(pos));
             }
         }
     }
@@ -1,4 +1,5 @@
 #include "../include/session/SessionStorage.h"
+#include <chrono>
 #include <iostream>
 
 namespace http
@@ -7,17 +8,59 @@ namespace http
 namespace session
 {
 
+namespace
+{
+
+const size_t kWheelSlots = 1024; // 时间轮槽数，每槽1秒
+
+int64_t nowSeconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+MemorySessionStorage::Shard::Shard(int64_t nowSec)
+    : wheel(kWheelSlots, nowSec)
+{
+}
+
+MemorySessionStorage::MemorySessionStorage(size_t numShards)
+{
+    // 分片数向上取整为2的幂，方便用位运算选择分片
+    size_t n = 1;
+    while (n < numShards)
+    {
+        n <<= 1;
+    }
+    int64_t now = nowSeconds();
+    shards_.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        shards_.push_back(std::make_unique<Shard>(now));
+    }
+}
+
 void MemorySessionStorage::save(std::shared_ptr<Session> session)
 {
-    // 创建会话副本并存储
-    sessions_[session->getId()] = session;
+    Shard& shard = shardFor(session->getId());
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto result = shard.sessions.insert_or_assign(session->getId(), session);
+    if (result.second)
+    {
+        // 新会话登记到时间轮，之后的刷新由清理时重新计算槽位
+        shard.wheel.add(session->getId(), session->getExpiryTime());
+    }
 }
 
 // 通过会话ID从存储中加载会话
 std::shared_ptr<Session> MemorySessionStorage::load(const std::string& sessionId)
 {
-    auto it = sessions_.find(sessionId);
-    if (it != sessions_.end())
+    Shard& shard = shardFor(sessionId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(sessionId);
+    if (it != shard.sessions.end())
     {
         if (!it->second->isExpired())
         {
@@ -26,7 +69,7 @@ std::shared_ptr<Session> MemorySessionStorage::load(const std::string& sessionId
         else
         {
             // 如果会话已过期，则从存储中移除
-            sessions_.erase(it);
+            shard.sessions.erase(it);
         }
     }
 
@@ -37,8 +80,45 @@ std::shared_ptr<Session> MemorySessionStorage::load(const std::string& sessionId
 // 通过会话ID从存储中移除会话
 void MemorySessionStorage::remove(const std::string& sessionId)
 {
-    sessions_.erase(sessionId);
+    Shard& shard = shardFor(sessionId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sessions.erase(sessionId);
+}
+
+// 推进各分片的时间轮，只检查到期槽中的会话
+void MemorySessionStorage::cleanExpired()
+{
+    int64_t now = nowSeconds();
+    for (auto& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->wheel.advance(now, [&shard](const std::string& sessionId) -> int64_t {
+            auto it = shard->sessions.find(sessionId);
+            if (it == shard->sessions.end())
+            {
+                return 0; // 已被移除
+            }
+            if (it->second->isExpired())
+            {
+                shard->sessions.erase(it);
+                return 0;
+            }
+            // 会话期间被刷新过，按新的过期时间重新登记
+            return it->second->getExpiryTime();
+        });
+    }
+}
+
+size_t MemorySessionStorage::size() const
+{
+    size_t total = 0;
+    for (const auto& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->sessions.size();
+    }
+    return total;
 }
 
 } // namespace session
-} // namespace http
\ No newline at end of file
+} // namespace http
@@ -0,0 +1,91 @@
+#include "../../include/ssl/HandshakePool.h"
+
+#include <algorithm>
+
+namespace ssl
+{
+
+namespace
+{
+
+const size_t kMaxQueuePerThread = 256; // 不限制并发握手数时每个握手线程的最大排队步骤数
+
+} // namespace
+
+HandshakePool::HandshakePool(int numThreads, size_t maxInFlight)
+    : pool_("HandshakePool")
+    , numThreads_(numThreads)
+    , maxInFlight_(maxInFlight)
+{
+    // 每个握手同时最多只有一个步骤在排队，队列长度不超过并发握手上限；
+    // 不限制并发数时按线程数限制队列，队列满时握手步骤留在IO线程中执行
+    size_t maxQueueSize = maxInFlight_;
+    if (maxQueueSize == 0)
+    {
+        maxQueueSize = kMaxQueuePerThread * static_cast<size_t>(std::max(numThreads_, 1));
+    }
+    pool_.setMaxQueueSize(maxQueueSize);
+}
+
+void HandshakePool::start()
+{
+    if (numThreads_ > 0)
+    {
+        pool_.start(numThreads_);
+    }
+}
+
+void HandshakePool::stop()
+{
+    pool_.stop();
+}
+
+bool HandshakePool::tryAcquire()
+{
+    if (++inFlight_ > static_cast<int64_t>(maxInFlight_) && maxInFlight_ > 0)
+    {
+        --inFlight_;
+        ++rejected_;
+        return false;
+    }
+    return true;
+}
+
+void HandshakePool::release()
+{
+    --inFlight_;
+}
+
+bool HandshakePool::submit(Task task)
+{
+    if (!pool_.trySubmit(std::move(task)))
+    {
+        return false;
+    }
+    ++offloaded_;
+    return true;
+}
+
+void HandshakePool::recordWait(int64_t waitUs)
+{
+    totalWaitUs_ += waitUs;
+    int64_t prev = maxWaitUs_.load();
+    while (waitUs > prev && !maxWaitUs_.compare_exchange_weak(prev, waitUs))
+    {
+    }
+}
+
+HandshakeStats HandshakePool::stats() const
+{
+    HandshakeStats stats;
+    stats.inFlight = inFlight_.load();
+    stats.rejected = rejected_.load();
+    stats.offloaded = offloaded_.load();
+    stats.queueSize = pool_.queueSize();
+    stats.avgWaitUs = stats.offloaded > 0
+        ? totalWaitUs_.load() / static_cast<int64_t>(stats.offloaded) : 0;
+    stats.maxWaitUs = maxWaitUs_.load();
+    return stats;
+}
+
+} // namespace ssl
@@ -9,6 +9,9 @@ SslConfig::SslConfig()
     , verifyDepth_(4)
     , sessionTimeout_(300)
     , sessionCacheSize_(20480L)
+    , sessionTickets_(true)
+    , ticketLifetime_(3600)
+    , ticketRotationInterval_(3600)
 {
 }
 
@@ -1,10 +1,14 @@
 #include "../../include/ssl/SslConnection.h"
 #include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
 #include <openssl/err.h>
+#include <climits>
 
 namespace ssl
 {
 
+static const size_t kMinReadSize = 16 * 1024; // 解密前保证解密缓冲区至少有一条最大TLS记录的空间
+
 // 自定义 BIO 方法
 static BIO_METHOD* createCustomBioMethod() 
 {
@@ -15,17 +19,27 @@ static BIO_METHOD* createCustomBioMethod()
     return method;
 }
 
-SslConnection::SslConnection(const TcpConnectionPtr& conn, SslContext* ctx)
+SslConnection::SslConnection(const TcpConnectionPtr& conn, SslContext* ctx,
+                             const std::shared_ptr<HandshakePool>& pool)
     : ssl_(nullptr)
     , ctx_(ctx)
-    , conn_(conn)
+    , conn_(conn.get())
     , state_(SSLState::HANDSHAKE)
     , readBio_(nullptr)
     , writeBio_(nullptr)
-    , messageCallback_(nullptr)
+    , flushQueued_(false)
+    , shutdownRequested_(false)
+    , pool_(pool)
+    , handshakeRunning_(false)
 {
-    // 创建 SSL 对象
-    ssl_ = SSL_new(ctx_->getNativeHandle());
+    if (pool)
+    {
+        // 名额由连接和正在执行的握手步骤共同持有，两者都放手后才归还
+        handshakeSlot_.reset(pool.get(), [pool](HandshakePool*) { pool->release(); });
+    }
+
+    // 创建 SSL 对象，最后一个引用释放时SSL_free同时释放BIO
+    ssl_.reset(ctx_->newSsl(), SSL_free);
     if (!ssl_) {
         LOG_ERROR << "Failed to create SSL object: " << ERR_error_string(ERR_get_error(), nullptr);
         return;
@@ -37,107 +51,160 @@ SslConnection::SslConnection(const TcpConnectionPtr& conn, SslContext* ctx)
     
     if (!readBio_ || !writeBio_) {
         LOG_ERROR << "Failed to create BIO objects";
-        SSL_free(ssl_);
-        ssl_ = nullptr;
+        BIO_free(readBio_);
+        BIO_free(writeBio_);
+        ssl_.reset();
         return;
     }
 
-    SSL_set_bio(ssl_, readBio_, writeBio_);
-    SSL_set_accept_state(ssl_);  // 设置为服务器模式
+    SSL_set_bio(ssl_.get(), readBio_, writeBio_);
+    SSL_set_accept_state(ssl_.get());  // 设置为服务器模式
     
     // 设置 SSL 选项
-    SSL_set_mode(ssl_, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
-    SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE);
-    
-    // 设置连接回调
-    conn_->setMessageCallback(
-        std::bind(&SslConnection::onRead, this, std::placeholders::_1,
-                 std::placeholders::_2, std::placeholders::_3));
+    SSL_set_mode(ssl_.get(), SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    SSL_set_mode(ssl_.get(), SSL_MODE_ENABLE_PARTIAL_WRITE);
 }
 
 SslConnection::~SslConnection() 
 {
-    if (ssl_) 
-    {
-        SSL_free(ssl_);  // 这会同时释放 BIO
-    }
+    // 握手线程中仍在执行的步骤持有ssl_和握手名额的引用，步骤返回后由它最后释放
+    releaseHandshakeSlot();
 }
 
 void SslConnection::startHandshake() 
 {
-    SSL_set_accept_state(ssl_);
+    SSL_set_accept_state(ssl_.get());
     handleHandshake();
 }
 
 void SslConnection::send(const void* data, size_t len) 
 {
-    if (state_ != SSLState::ESTABLISHED) {
-        LOG_ERROR << "Cannot send data before SSL handshake is complete";
+    if (state_ == SSLState::SHUTDOWN || state_ == SSLState::ERROR || shutdownRequested_)
+    {
         return;
     }
-    
-    int written = SSL_write(ssl_, data, len);
-    if (written <= 0) {
-        int err = SSL_get_error(ssl_, written);
-        LOG_ERROR << "SSL_write failed: " << ERR_error_string(err, nullptr);
+    writeBuffer_.append(static_cast<const char*>(data), len);
+    if (state_ == SSLState::ESTABLISHED)
+    {
+        queueFlush();
+    }
+}
+
+void SslConnection::shutdown()
+{
+    if (state_ != SSLState::ESTABLISHED)
+    {
+        conn_->shutdown(); // 握手未完成，没有可以发送的数据
         return;
     }
-    
-    char buf[4096];
-    int pending;
-    while ((pending = BIO_pending(writeBio_)) > 0) {
-        int bytes = BIO_read(writeBio_, buf, 
-                           std::min(pending, static_cast<int>(sizeof(buf))));
-        if (bytes > 0) {
-            conn_->send(buf, bytes);
+    shutdownRequested_ = true;
+    queueFlush();
+}
+
+void SslConnection::flush()
+{
+    if (state_ != SSLState::ESTABLISHED)
+    {
+        return; // 握手完成后再发送
+    }
+
+    // 明文一次交给SSL_write，OpenSSL按最大记录长度切分，减少记录数和调用次数
+    while (writeBuffer_.readableBytes() > 0)
+    {
+        int len = static_cast<int>(std::min(writeBuffer_.readableBytes(), static_cast<size_t>(INT_MAX)));
+        int written = SSL_write(ssl_.get(), writeBuffer_.peek(), len);
+        if (written <= 0)
+        {
+            handleError(getLastError(written));
+            return;
         }
+        writeBuffer_.retrieve(written);
+    }
+
+    if (shutdownRequested_)
+    {
+        SSL_shutdown(ssl_.get()); // 写入close_notify
+        state_ = SSLState::SHUTDOWN;
+        flushWriteBio();
+        conn_->shutdown();
+        return;
     }
+    flushWriteBio();
 }
 
 void SslConnection::onRead(const TcpConnectionPtr& conn, BufferPtr buf, 
                          muduo::Timestamp time) 
 {
-    if (state_ == SSLState::HANDSHAKE) {
-        // 将数据写入 BIO
-        BIO_write(readBio_, buf->peek(), buf->readableBytes());
-        buf->retrieve(buf->readableBytes());
-        handleHandshake();
+    if (handshakeRunning_)
+    {
+        // SSL对象正在握手线程中使用，步骤完成后再交给它
+        readBuffer_.append(buf->peek(), buf->readableBytes());
+        buf->retrieveAll();
         return;
-    } else if (state_ == SSLState::ESTABLISHED) {
-        // 解密数据
-        char decryptedData[4096];
-        int ret = SSL_read(ssl_, decryptedData, sizeof(decryptedData));
-        if (ret > 0) {
-            // 创建新的 Buffer 存储解密后的数据
-            muduo::net::Buffer decryptedBuffer;
-            decryptedBuffer.append(decryptedData, ret);
-            
-            // 调用上层回调处理解密后的数据
-            if (messageCallback_) {
-                messageCallback_(conn, &decryptedBuffer, time);
-            }
+    }
+    // 收到的密文全部交给SSL，不完整的记录留在readBio_中等待后续数据
+    BIO_write(readBio_, buf->peek(), static_cast<int>(buf->readableBytes()));
+    buf->retrieveAll();
+
+    if (state_ == SSLState::HANDSHAKE)
+    {
+        handleHandshake();
+    }
+    // 握手完成的同一个读事件中可能已经带有请求数据
+    if (state_ == SSLState::ESTABLISHED)
+    {
+        readRecords();
+    }
+}
+
+void SslConnection::readRecords()
+{
+    // 直接解密到解密缓冲区的可写区域，循环直到readBio_中没有完整的记录
+    while (true)
+    {
+        decryptedBuffer_.ensureWritableBytes(kMinReadSize);
+        int ret = SSL_read(ssl_.get(), decryptedBuffer_.beginWrite(), 
+                           static_cast<int>(std::min(decryptedBuffer_.writableBytes(), static_cast<size_t>(INT_MAX))));
+        if (ret > 0)
+        {
+            decryptedBuffer_.hasWritten(ret);
+            continue;
+        }
+
+        int err = SSL_get_error(ssl_.get(), ret);
+        if (err == SSL_ERROR_ZERO_RETURN)
+        {
+            // 对端发送了close_notify，发完已经生成的响应后关闭
+            shutdown();
         }
+        else if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE)
+        {
+            handleError(getLastError(ret));
+        }
+        break;
     }
+    // 读取过程中SSL可能需要回复(如TLS 1.3的KeyUpdate)
+    flushWriteBio();
 }
 
 void SslConnection::handleHandshake() 
 {
-    int ret = SSL_do_handshake(ssl_);
+    // 还没有收到ClientHello时SSL_do_handshake不做计算，不必交给握手线程
+    if (pool_ && pool_->offloading() && BIO_ctrl_pending(readBio_) > 0 && offloadHandshake())
+    {
+        return;
+    }
+
+    int ret = SSL_do_handshake(ssl_.get());
+    // 握手消息(或失败时的告警)需要立即发给对端
+    flushWriteBio();
     
     if (ret == 1) {
-        state_ = SSLState::ESTABLISHED;
-        LOG_INFO << "SSL handshake completed successfully";
-        LOG_INFO << "Using cipher: " << SSL_get_cipher(ssl_);
-        LOG_INFO << "Protocol version: " << SSL_get_version(ssl_);
-        
-        // 握手完成后，确保设置了正确的回调
-        if (!messageCallback_) {
-            LOG_WARN << "No message callback set after SSL handshake";
-        }
+        handshakeCompleted();
         return;
     }
     
-    int err = SSL_get_error(ssl_, ret);
+    int err = SSL_get_error(ssl_.get(), ret);
     switch (err) {
         case SSL_ERROR_WANT_READ:
         case SSL_ERROR_WANT_WRITE:
@@ -149,27 +216,169 @@ void SslConnection::handleHandshake()
             char errBuf[256];
             unsigned long errCode = ERR_get_error();
             ERR_error_string_n(errCode, errBuf, sizeof(errBuf));
-            LOG_ERROR << "SSL handshake failed: " << errBuf;
-            conn_->shutdown();  // 关闭连接
+            handshakeFailed(errBuf);
             break;
         }
     }
 }
 
-void SslConnection::onEncrypted(const char* data, size_t len) 
+bool SslConnection::offloadHandshake()
 {
-    writeBuffer_.append(data, len);
-    conn_->send(&writeBuffer_);
+    std::shared_ptr<SSL> ssl = ssl_;
+    std::shared_ptr<HandshakePool> slot = handshakeSlot_; // 步骤执行期间连接关闭时，名额在步骤返回后才归还
+    muduo::net::EventLoop* loop = conn_->getLoop();
+    std::weak_ptr<muduo::net::TcpConnection> weakConn(conn_->shared_from_this());
+    muduo::Timestamp submitTime = muduo::Timestamp::now();
+
+    handshakeRunning_ = true;
+    bool submitted = pool_->submit([this, ssl, slot, loop, weakConn, submitTime]() mutable {
+        slot->recordWait(muduo::Timestamp::now().microSecondsSinceEpoch() - submitTime.microSecondsSinceEpoch());
+
+        // 握手线程中只使用SSL对象，连接可能已经关闭，不能访问this
+        int ret = SSL_do_handshake(ssl.get());
+        std::string error;
+        if (ret != 1)
+        {
+            int err = SSL_get_error(ssl.get(), ret);
+            if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE)
+            {
+                char errBuf[256];
+                ERR_error_string_n(ERR_get_error(), errBuf, sizeof(errBuf));
+                error = errBuf;
+            }
+        }
+        // 错误队列是线程局部的，不能留给这个线程中的下一个握手
+        ERR_clear_error();
+
+        char* data = nullptr;
+        long len = BIO_get_mem_data(SSL_get_wbio(ssl.get()), &data);
+        std::string output(data, len > 0 ? static_cast<size_t>(len) : 0);
+        (void) BIO_reset(SSL_get_wbio(ssl.get()));
+        slot.reset();
+
+        // 和queueFlush一样，连接未断开时this有效
+        loop->queueInLoop([this, weakConn, ret, output = std::move(output), error = std::move(error)]() {
+            TcpConnectionPtr conn = weakConn.lock();
+            if (conn && !conn->disconnected())
+            {
+                onHandshakeStep(ret, output, error);
+            }
+        });
+    });
+    if (!submitted)
+    {
+        handshakeRunning_ = false;
+    }
+    return submitted;
 }
 
-void SslConnection::onDecrypted(const char* data, size_t len) 
+void SslConnection::onHandshakeStep(int ret, const std::string& output, const std::string& error)
 {
-    decryptedBuffer_.append(data, len);
+    handshakeRunning_ = false;
+    if (!output.empty())
+    {
+        conn_->send(output.data(), static_cast<int>(output.size()));
+    }
+
+    if (ret == 1)
+    {
+        handshakeCompleted();
+        // 握手期间收到的数据，如TLS 1.3客户端紧跟在Finished后面发出的请求
+        if (readBuffer_.readableBytes() > 0)
+        {
+            BIO_write(readBio_, readBuffer_.peek(), static_cast<int>(readBuffer_.readableBytes()));
+            readBuffer_.retrieveAll();
+        }
+        readRecords();
+        if (handshakeCallback_ && state_ == SSLState::ESTABLISHED)
+        {
+            handshakeCallback_(conn_->shared_from_this());
+        }
+        return;
+    }
+    if (!error.empty())
+    {
+        handshakeFailed(error.c_str());
+        return;
+    }
+
+    // 握手还需要对端的数据，步骤执行期间已经收到的交给下一步
+    if (readBuffer_.readableBytes() > 0)
+    {
+        BIO_write(readBio_, readBuffer_.peek(), static_cast<int>(readBuffer_.readableBytes()));
+        readBuffer_.retrieveAll();
+        handleHandshake();
+    }
+}
+
+void SslConnection::handshakeCompleted()
+{
+    state_ = SSLState::ESTABLISHED;
+    releaseHandshakeSlot();
+    ctx_->recordHandshake(SSL_session_reused(ssl_.get()) == 1);
+    LOG_DEBUG << "SSL handshake completed, " << SSL_get_version(ssl_.get()) << " " << SSL_get_cipher(ssl_.get())
+              << (SSL_session_reused(ssl_.get()) ? " (resumed)" : "");
+
+    // 握手期间积累的待发送数据
+    if (writeBuffer_.readableBytes() > 0 || shutdownRequested_)
+    {
+        queueFlush();
+    }
+}
+
+void SslConnection::handshakeFailed(const char* error)
+{
+    LOG_ERROR << "SSL handshake failed: " << error;
+    state_ = SSLState::ERROR;
+    releaseHandshakeSlot();
+    conn_->shutdown();  // 关闭连接
+}
+
+void SslConnection::releaseHandshakeSlot()
+{
+    handshakeSlot_.reset();
+}
+
+void SslConnection::flushWriteBio()
+{
+    // 直接引用writeBio_中的数据交给连接，不再分块拷贝
+    char* data = nullptr;
+    long len = BIO_get_mem_data(writeBio_, &data);
+    if (len > 0)
+    {
+        // 一次flush加密的数据可能超过int的范围，分段交给连接
+        for (long offset = 0; offset < len; )
+        {
+            int n = static_cast<int>(std::min(len - offset, static_cast<long>(INT_MAX)));
+            conn_->send(data + offset, n);
+            offset += n;
+        }
+        (void) BIO_reset(writeBio_);
+    }
+}
+
+void SslConnection::queueFlush()
+{
+    if (flushQueued_)
+    {
+        return;
+    }
+    flushQueued_ = true;
+    // 连接断开(状态变为disconnected)后才会销毁连接状态和本对象，因此连接未断开时this有效
+    std::weak_ptr<muduo::net::TcpConnection> weakConn(conn_->shared_from_this());
+    conn_->getLoop()->queueInLoop([this, weakConn]() {
+        TcpConnectionPtr conn = weakConn.lock();
+        if (conn && !conn->disconnected())
+        {
+            flushQueued_ = false;
+            flush();
+        }
+    });
 }
 
 SSLError SslConnection::getLastError(int ret) 
 {
-    int err = SSL_get_error(ssl_, ret);
+    int err = SSL_get_error(ssl_.get(), ret);
     switch (err) 
     {
         case SSL_ERROR_NONE:
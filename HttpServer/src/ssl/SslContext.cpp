@@ -1,22 +1,58 @@
 #include "../../include/ssl/SslContext.h"
 #include <muduo/base/Logging.h>
 #include <openssl/err.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cctype>
+#include <string>
 
 namespace ssl
 {
+SslContext::CertificateSet::~CertificateSet()
+{
+    // 已建立的连接各自持有SSL_CTX的引用，这里只释放本组的引用
+    for (SSL_CTX* ctx : contexts)
+    {
+        SSL_CTX_free(ctx);
+    }
+}
+
+SSL_CTX* SslContext::CertificateSet::find(const std::string& serverName) const
+{
+    std::string name(serverName);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const auto& entry : names)
+    {
+        if (entry.first == name)
+        {
+            return entry.second;
+        }
+    }
+    // 通配符只匹配最左边的一级: *.example.com 匹配 a.example.com，不匹配 a.b.example.com
+    size_t dot = name.find('.');
+    if (dot != std::string::npos && dot > 0)
+    {
+        std::string wildcard = "*" + name.substr(dot);
+        for (const auto& entry : names)
+        {
+            if (entry.first == wildcard)
+            {
+                return entry.second;
+            }
+        }
+    }
+    return nullptr;
+}
+
 SslContext::SslContext(const SslConfig& config)
-    : ctx_(nullptr)
-    , config_(config)
+    : configs_(1, config)
 {
 
 }
 
 SslContext::~SslContext()
 {
-    if (ctx_)
-    {
-        SSL_CTX_free(ctx_);
-    }
 }
 
 bool SslContext::initialize()
@@ -25,70 +61,196 @@ bool SslContext::initialize()
     OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS | 
                     OPENSSL_INIT_LOAD_CRYPTO_STRINGS, nullptr);
 
-    // 创建 SSL 上下文
-    const SSL_METHOD* method = TLS_server_method();
-    ctx_ = SSL_CTX_new(method);
-    if (!ctx_)
+    // 会话票据密钥由所有证书共享，证书重新加载后之前签发的票据仍然有效
+    const SslConfig& config = configs_.front();
+    if (config.getSessionTickets())
+    {
+        ticketKeys_ = std::make_unique<TicketKeyRing>(config.getTicketKeyFile(), config.getTicketLifetime());
+        if (!ticketKeys_->initialize())
+        {
+            ticketKeys_.reset();
+            return false;
+        }
+    }
+
+    FileTimes fileTimes = certificateFileTimes();
+    CertificateSetPtr certificates = loadCertificateSet();
+    if (!certificates)
     {
-        handleSslError("Failed to create SSL context");
         return false;
     }
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex_);
+        fileTimes_ = std::move(fileTimes);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        certificates_ = std::move(certificates);
+    }
 
-    // 设置 SSL 选项
-    long options = SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | 
-                  SSL_OP_NO_COMPRESSION |
-                  SSL_OP_CIPHER_SERVER_PREFERENCE;
-    SSL_CTX_set_options(ctx_, options);
+    LOG_INFO << "SSL context initialized successfully with " << configs_.size() << " certificate(s)";
+    return true;
+}
 
-    // 加载证书和私钥
-    if (!loadCertificates())
+bool SslContext::addConfig(const SslConfig& config)
+{
+    configs_.push_back(config);
+    if (!certificates())
     {
+        return true; // 在initialize中统一创建
+    }
+    if (!rebuild())
+    {
+        configs_.pop_back();
         return false;
     }
+    return true;
+}
 
-    // 设置协议版本
-    if (!setupProtocol())
+bool SslContext::reload()
+{
+    if (!rebuild())
     {
+        LOG_ERROR << "Failed to reload certificates, keep using the current ones";
         return false;
     }
+    ++reloads_;
+    LOG_WARN << "Certificates reloaded";
+    return true;
+}
 
-    // 设置会话缓存
-    setupSessionCache();
-
-    LOG_INFO << "SSL context initialized successfully";
+bool SslContext::rebuild()
+{
+    std::lock_guard<std::mutex> reloadLock(reloadMutex_);
+    // 先记录修改时间再读取文件，读取期间文件再被修改时下次检查仍会发现
+    fileTimes_ = certificateFileTimes();
+    CertificateSetPtr certificates = loadCertificateSet();
+    if (!certificates)
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        certificates_.swap(certificates);
+    }
+    // 原来的证书在这里(或最后一个使用它的连接断开时)释放
     return true;
 }
 
-bool SslContext::loadCertificates()
+bool SslContext::certificatesChanged() const
+{
+    FileTimes fileTimes = certificateFileTimes();
+    // 正在重新加载时不等待，加载完后的下一次检查再比较
+    std::unique_lock<std::mutex> lock(reloadMutex_, std::try_to_lock);
+    return lock.owns_lock() && fileTimes != fileTimes_;
+}
+
+SSL* SslContext::newSsl()
+{
+    CertificateSetPtr certificates = this->certificates();
+    // SSL_new持有SSL_CTX的引用，之后证书被替换也不影响这个连接
+    return certificates ? SSL_new(certificates->contexts.front()) : nullptr;
+}
+
+SSL_CTX* SslContext::getNativeHandle() const
+{
+    CertificateSetPtr certificates = this->certificates();
+    return certificates ? certificates->contexts.front() : nullptr;
+}
+
+SslContext::CertificateSetPtr SslContext::certificates() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return certificates_;
+}
+
+SslContext::CertificateSetPtr SslContext::loadCertificateSet()
+{
+    auto certificates = std::make_shared<CertificateSet>();
+    for (const SslConfig& config : configs_)
+    {
+        SSL_CTX* ctx = createContext(config);
+        if (!ctx)
+        {
+            return nullptr; // 已创建的SSL_CTX随certificates释放
+        }
+        certificates->contexts.push_back(ctx);
+        for (std::string name : config.getServerNames())
+        {
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            certificates->names.emplace_back(std::move(name), ctx);
+        }
+    }
+    if (configs_.size() > 1)
+    {
+        // 只有默认证书的SSL_CTX会收到ClientHello，由它切换到其他证书
+        SSL_CTX_set_tlsext_servername_callback(certificates->contexts.front(), &SslContext::serverNameCallback);
+        SSL_CTX_set_tlsext_servername_arg(certificates->contexts.front(), this);
+    }
+    return certificates;
+}
+
+SSL_CTX* SslContext::createContext(const SslConfig& config)
+{
+    // 创建 SSL 上下文
+    const SSL_METHOD* method = TLS_server_method();
+    SSL_CTX* ctx = SSL_CTX_new(method);
+    if (!ctx)
+    {
+        handleSslError("Failed to create SSL context");
+        return nullptr;
+    }
+
+    // 设置 SSL 选项
+    long options = SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | 
+                  SSL_OP_NO_COMPRESSION |
+                  SSL_OP_CIPHER_SERVER_PREFERENCE;
+    SSL_CTX_set_options(ctx, options);
+
+    // 加载证书和私钥，设置协议版本
+    if (!loadCertificates(ctx, config) || !setupProtocol(ctx, config))
+    {
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    // 设置会话缓存和会话票据
+    setupSessionCache(ctx, config);
+    setupSessionTickets(ctx, config);
+    return ctx;
+}
+
+bool SslContext::loadCertificates(SSL_CTX* ctx, const SslConfig& config)
 {
     // 加载证书
-    if (SSL_CTX_use_certificate_file(ctx_,
-     config_.getCertificateFile().c_str(), SSL_FILETYPE_PEM) <= 0)
+    if (SSL_CTX_use_certificate_file(ctx,
+     config.getCertificateFile().c_str(), SSL_FILETYPE_PEM) <= 0)
     {
         handleSslError("Failed to load server certificate");
         return false;
     }
 
     // 加载私钥
-    if (SSL_CTX_use_PrivateKey_file(ctx_, 
-        config_.getPrivateKeyFile().c_str(), SSL_FILETYPE_PEM) <= 0)
+    if (SSL_CTX_use_PrivateKey_file(ctx, 
+        config.getPrivateKeyFile().c_str(), SSL_FILETYPE_PEM) <= 0)
     {
         handleSslError("Failed to load private key");
         return false;
     }
 
     // 验证私钥
-    if (!SSL_CTX_check_private_key(ctx_))
+    if (!SSL_CTX_check_private_key(ctx))
     {
         handleSslError("Private key does not match the certificate");
         return false;
     }
 
     // 加载证书链
-    if (!config_.getCertificateChainFile().empty())
+    if (!config.getCertificateChainFile().empty())
     {
-        if (SSL_CTX_use_certificate_chain_file(ctx_,
-            config_.getCertificateChainFile().c_str()) <= 0)
+        if (SSL_CTX_use_certificate_chain_file(ctx,
+            config.getCertificateChainFile().c_str()) <= 0)
         {
             handleSslError("Failed to load certificate chain");
             return false;
@@ -98,11 +260,11 @@ bool SslContext::loadCertificates()
     return true;
 }
 
-bool SslContext::setupProtocol()
+bool SslContext::setupProtocol(SSL_CTX* ctx, const SslConfig& config)
 {
     // 设置 SSL/TLS 协议版本
     long options = SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3;
-    switch (config_.getProtocolVersion())
+    switch (config.getProtocolVersion())
     {
         case SSLVersion::TLS_1_0:
             options |= SSL_OP_NO_TLSv1;
@@ -117,13 +279,13 @@ bool SslContext::setupProtocol()
             options |= SSL_OP_NO_TLSv1_3;
             break;
     }
-    SSL_CTX_set_options(ctx_, options);
+    SSL_CTX_set_options(ctx, options);
     
     // 设置加密套件
-    if (!config_.getCipherList().empty())
+    if (!config.getCipherList().empty())
     {
-        if (SSL_CTX_set_cipher_list(ctx_,
-            config_.getCipherList().c_str()) <= 0)
+        if (SSL_CTX_set_cipher_list(ctx,
+            config.getCipherList().c_str()) <= 0)
         {
             handleSslError("Failed to set cipher list");
             return false;
@@ -133,11 +295,81 @@ bool SslContext::setupProtocol()
     return true;
 }
 
-void SslContext::setupSessionCache()
+void SslContext::setupSessionCache(SSL_CTX* ctx, const SslConfig& config)
+{
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, config.getSessionCacheSize());
+    SSL_CTX_set_timeout(ctx, config.getSessionTimeout());
+}
+
+void SslContext::setupSessionTickets(SSL_CTX* ctx, const SslConfig& config)
+{
+    if (!ticketKeys_ || !config.getSessionTickets())
+    {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        return;
+    }
+    // 票据有效期由票据回调处理，SSL_CTX_set_timeout只用于会话缓存
+    ticketKeys_->install(ctx, config.getTicketLifetime());
+}
+
+void SslContext::rotateTicketKeys()
+{
+    if (ticketKeys_)
+    {
+        ticketKeys_->rotate();
+    }
+}
+
+SslStats SslContext::stats() const
+{
+    SslStats stats;
+    stats.fullHandshakes = fullHandshakes_.load();
+    stats.resumedHandshakes = resumedHandshakes_.load();
+    stats.reloads = reloads_.load();
+    return stats;
+}
+
+SslContext::FileTimes SslContext::certificateFileTimes() const
 {
-    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
-    SSL_CTX_sess_set_cache_size(ctx_, config_.getSessionCacheSize());
-    SSL_CTX_set_timeout(ctx_, config_.getSessionTimeout());
+    FileTimes fileTimes;
+    for (const SslConfig& config : configs_)
+    {
+        for (const std::string* path : { &config.getCertificateFile(), 
+                                         &config.getPrivateKeyFile(), 
+                                         &config.getCertificateChainFile() })
+        {
+            struct stat st;
+            if (!path->empty())
+            {
+                fileTimes.emplace_back(*path, ::stat(path->c_str(), &st) == 0 ? st.st_mtime : 0);
+            }
+        }
+    }
+    return fileTimes;
+}
+
+int SslContext::serverNameCallback(SSL* ssl, int* alert, void* arg)
+{
+    const char* serverName = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    if (!serverName)
+    {
+        return SSL_TLSEXT_ERR_NOACK; // 客户端没有发送SNI，使用默认证书
+    }
+    auto self = static_cast<SslContext*>(arg);
+    // 按当前证书查找，握手期间证书被替换时新旧证书都可以正常完成握手
+    CertificateSetPtr certificates = self->certificates();
+    SSL_CTX* ctx = certificates ? certificates->find(serverName) : nullptr;
+    if (ctx && ctx != SSL_get_SSL_CTX(ssl))
+    {
+        SSL_set_SSL_CTX(ssl, ctx);
+        // SSL_set_SSL_CTX不会带上新证书的选项，未启用票据的证书不签发票据
+        if (SSL_CTX_get_options(ctx) & SSL_OP_NO_TICKET)
+        {
+            SSL_set_options(ssl, SSL_OP_NO_TICKET);
+        }
+    }
+    return SSL_TLSEXT_ERR_OK;
 }
 
 void SslContext::handleSslError(const char* msg)
@@ -0,0 +1,270 @@
+#include "../../include/ssl/TicketKeyRing.h"
+#include <muduo/base/Logging.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace ssl
+{
+
+// SSL_CTX上保存密钥环指针的ex_data索引
+static int ticketKeyRingIndex()
+{
+    static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+// SSL_CTX上保存票据有效期的ex_data索引
+static int ticketLifetimeIndex()
+{
+    static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+TicketKeyRing::TicketKeyRing(const std::string& keyFile, int lifetime)
+    : keyFile_(keyFile)
+    , lifetime_(lifetime)
+{
+}
+
+bool TicketKeyRing::initialize()
+{
+    std::vector<Key> keys;
+    if (!keyFile_.empty())
+    {
+        if (!loadKeyFile(&keys))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        keys.resize(1);
+        if (!generateKey(&keys[0]))
+        {
+            return false;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    keys_.swap(keys);
+    return true;
+}
+
+void TicketKeyRing::rotate()
+{
+    time_t now = ::time(nullptr);
+    if (!keyFile_.empty())
+    {
+        // 密钥文件由外部轮换，这里只重新加载，加载失败时继续使用原来的密钥
+        std::vector<Key> keys;
+        if (loadKeyFile(&keys))
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            keys_.swap(keys);
+        }
+        return;
+    }
+
+    Key key;
+    if (!generateKey(&key))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 原来的当前密钥退役，之后只用于解密它签发的票据，过了票据有效期后删除
+    for (Key& old : keys_)
+    {
+        if (old.expire == 0)
+        {
+            old.expire = now + lifetime_;
+        }
+    }
+    keys_.erase(std::remove_if(keys_.begin(), keys_.end(),
+                               [now](const Key& old) { return old.expire <= now; }),
+                keys_.end());
+    keys_.insert(keys_.begin(), key);
+    LOG_INFO << "Session ticket keys rotated, " << keys_.size() << " keys in ring";
+}
+
+void TicketKeyRing::install(SSL_CTX* ctx, int lifetime)
+{
+    SSL_CTX_set_ex_data(ctx, ticketKeyRingIndex(), this);
+    SSL_CTX_set_ex_data(ctx, ticketLifetimeIndex(), reinterpret_cast<void*>(static_cast<intptr_t>(lifetime)));
+    SSL_CTX_set_session_ticket_cb(ctx, &TicketKeyRing::generateTicketCallback,
+                                  &TicketKeyRing::decryptTicketCallback, nullptr);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, &TicketKeyRing::ticketKeyCallback);
+#else
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx, &TicketKeyRing::ticketKeyCallback);
+#endif
+}
+
+bool TicketKeyRing::loadKeyFile(std::vector<Key>* keys) const
+{
+    std::ifstream file(keyFile_, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file.good() && !file.eof())
+    {
+        LOG_ERROR << "Failed to read session ticket key file " << keyFile_;
+        return false;
+    }
+    if (data.empty() || data.size() % kKeyFileEntrySize != 0)
+    {
+        LOG_ERROR << "Session ticket key file " << keyFile_ << " must contain multiples of "
+                  << kKeyFileEntrySize << " bytes";
+        return false;
+    }
+
+    keys->clear();
+    for (size_t offset = 0; offset < data.size(); offset += kKeyFileEntrySize)
+    {
+        Key key;
+        const char* entry = data.data() + offset;
+        memcpy(key.name, entry, sizeof key.name);
+        memcpy(key.hmacKey, entry + 16, sizeof key.hmacKey);
+        memcpy(key.aesKey, entry + 48, sizeof key.aesKey);
+        // 文件中的密钥都可用于解密，轮换时整体替换，不需要退役时间
+        key.expire = 0;
+        keys->push_back(key);
+    }
+    return true;
+}
+
+bool TicketKeyRing::generateKey(Key* key) const
+{
+    if (RAND_bytes(key->name, sizeof key->name) != 1
+        || RAND_bytes(key->hmacKey, sizeof key->hmacKey) != 1
+        || RAND_bytes(key->aesKey, sizeof key->aesKey) != 1)
+    {
+        LOG_ERROR << "Failed to generate session ticket key";
+        return false;
+    }
+    key->expire = 0;
+    return true;
+}
+
+bool TicketKeyRing::findKey(const unsigned char* name, bool encrypt, Key* key, bool* current)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (keys_.empty())
+    {
+        return false;
+    }
+    if (encrypt)
+    {
+        *key = keys_.front();
+        *current = true;
+        return true;
+    }
+    for (size_t i = 0; i < keys_.size(); ++i)
+    {
+        if (memcmp(keys_[i].name, name, sizeof keys_[i].name) == 0)
+        {
+            *key = keys_[i];
+            *current = i == 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+int TicketKeyRing::lifetimeOf(SSL* ssl)
+{
+    // SNI选择证书后SSL_get_SSL_CTX返回对应证书的SSL_CTX
+    return static_cast<int>(reinterpret_cast<intptr_t>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ticketLifetimeIndex())));
+}
+
+int TicketKeyRing::generateTicketCallback(SSL* ssl, void*)
+{
+    // TLS 1.2签发票据的会话同时进入会话缓存，保持会话缓存的超时，票据有效期在解密时检查
+    SSL_SESSION* session = SSL_get_session(ssl);
+    int lifetime = lifetimeOf(ssl);
+    if (session && lifetime > 0 && SSL_SESSION_get_protocol_version(session) >= TLS1_3_VERSION)
+    {
+        SSL_SESSION_set_timeout(session, lifetime);
+    }
+    return 1;
+}
+
+SSL_TICKET_RETURN TicketKeyRing::decryptTicketCallback(SSL* ssl, SSL_SESSION* session,
+                                                       const unsigned char*, size_t,
+                                                       SSL_TICKET_STATUS status, void*)
+{
+    if (status != SSL_TICKET_SUCCESS && status != SSL_TICKET_SUCCESS_RENEW)
+    {
+        return SSL_TICKET_RETURN_IGNORE_RENEW; // 没有票据或无法解密，完整握手后签发新票据
+    }
+    int lifetime = lifetimeOf(ssl);
+    if (lifetime > 0 && ::time(nullptr) - SSL_SESSION_get_time(session) > lifetime)
+    {
+        return SSL_TICKET_RETURN_IGNORE_RENEW;
+    }
+    return status == SSL_TICKET_SUCCESS ? SSL_TICKET_RETURN_USE : SSL_TICKET_RETURN_USE_RENEW;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int TicketKeyRing::ticketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv,
+                                     EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int enc)
+#else
+int TicketKeyRing::ticketKeyCallback(SSL* ssl, unsigned char* name, unsigned char* iv,
+                                     EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* macCtx, int enc)
+#endif
+{
+    auto ring = static_cast<TicketKeyRing*>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ticketKeyRingIndex()));
+    if (!ring)
+    {
+        return 0; // 当前证书未启用会话票据，不签发也不接受票据
+    }
+
+    Key key;
+    bool current = false;
+    if (!ring->findKey(name, enc == 1, &key, &current))
+    {
+        return 0; // 未知密钥签发的票据，进行完整握手
+    }
+
+    if (enc == 1)
+    {
+        memcpy(name, key.name, sizeof key.name);
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1
+            || EVP_EncryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, key.aesKey, iv) != 1)
+        {
+            return -1;
+        }
+    }
+    else if (EVP_DecryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, key.aesKey, iv) != 1)
+    {
+        return -1;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmacKey, sizeof key.hmacKey),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0),
+        OSSL_PARAM_construct_end()
+    };
+    if (EVP_MAC_CTX_set_params(macCtx, params) != 1)
+    {
+        return -1;
+    }
+#else
+    if (HMAC_Init_ex(macCtx, key.hmacKey, sizeof key.hmacKey, EVP_sha256(), nullptr) != 1)
+    {
+        return -1;
+    }
+#endif
+    // 旧密钥签发的票据仍可恢复会话，返回2让OpenSSL用当前密钥签发新票据
+    return current ? 1 : 2;
+}
+
+} // namespace ssl
@@ -0,0 +1,192 @@
+#include "../../include/utils/StaticFileCache.h"
+
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+StaticFileCache::StaticFileCache(const std::string& rootDir)
+    : rootDir_(rootDir)
+    , inotifyFd_(-1)
+{
+}
+
+StaticFileCache::~StaticFileCache()
+{
+    if (inotifyChannel_)
+    {
+        inotifyChannel_->disableAll();
+        inotifyChannel_->remove();
+    }
+    if (inotifyFd_ >= 0)
+    {
+        ::close(inotifyFd_);
+    }
+}
+
+int StaticFileCache::load()
+{
+    DIR* dir = ::opendir(rootDir_.c_str());
+    if (!dir)
+    {
+        LOG_ERROR << "StaticFileCache cannot open " << rootDir_;
+        return -1;
+    }
+
+    int count = 0;
+    while (struct dirent* entry = ::readdir(dir))
+    {
+        std::string name(entry->d_name);
+        if (name == "." || name == "..")
+        {
+            continue;
+        }
+        reload(name);
+        ++count;
+    }
+    ::closedir(dir);
+
+    LOG_INFO << "StaticFileCache loaded " << count << " files from " << rootDir_;
+    return count;
+}
+
+void StaticFileCache::watch(muduo::net::EventLoop* loop)
+{
+    loop->assertInLoopThread();
+    inotifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0)
+    {
+        LOG_SYSERR << "inotify_init1 failed, static files will not be reloaded";
+        return;
+    }
+    // 编辑器保存文件可能是原地写入(CLOSE_WRITE)，也可能是写临时文件再改名(MOVED_TO)
+    if (::inotify_add_watch(inotifyFd_, rootDir_.c_str(),
+                            IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) < 0)
+    {
+        LOG_SYSERR << "inotify_add_watch " << rootDir_ << " failed";
+        ::close(inotifyFd_);
+        inotifyFd_ = -1;
+        return;
+    }
+
+    inotifyChannel_ = std::make_unique<muduo::net::Channel>(loop, inotifyFd_);
+    inotifyChannel_->setReadCallback(std::bind(&StaticFileCache::handleInotify, this));
+    inotifyChannel_->enableReading();
+}
+
+StaticFileCache::AssetPtr StaticFileCache::get(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = assets_.find(name);
+    return it != assets_.end() ? it->second : nullptr;
+}
+
+std::string StaticFileCache::contentTypeOf(const std::string& name)
+{
+    static const std::unordered_map<std::string, std::string> kTypes = {
+        {"html", "text/html"},
+        {"htm", "text/html"},
+        {"css", "text/css"},
+        {"js", "application/javascript"},
+        {"json", "application/json"},
+        {"txt", "text/plain"},
+        {"svg", "image/svg+xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"ico", "image/x-icon"},
+    };
+
+    size_t dot = name.rfind('.');
+    if (dot != std::string::npos)
+    {
+        auto it = kTypes.find(name.substr(dot + 1));
+        if (it != kTypes.end())
+        {
+            return it->second;
+        }
+    }
+    return "application/octet-stream";
+}
+
+std::string StaticFileCache::etagOf(const std::string& content)
+{
+    // FNV-1a 64位哈希，只在加载文件时计算一次
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : content)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char buf[32];
+    snprintf(buf, sizeof buf, "\"%016llx-%zx\"", static_cast<unsigned long long>(hash), content.size());
+    return buf;
+}
+
+// 重新加载一个文件，文件已不存在时从缓存中移除
+void StaticFileCache::reload(const std::string& name)
+{
+    std::string path = rootDir_ + "/" + name;
+    struct stat st;
+    std::ifstream file(path, std::ios::binary);
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || !file.is_open())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (assets_.erase(name) > 0)
+        {
+            LOG_INFO << "StaticFileCache removed " << name;
+        }
+        return;
+    }
+
+    // 在锁外读文件，读完后整体替换，正在使用旧版本的响应不受影响
+    auto content = std::make_shared<std::string>();
+    content->reserve(st.st_size);
+    content->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    auto asset = std::make_shared<Asset>();
+    asset->name = name;
+    asset->content = std::move(content);
+    asset->contentType = contentTypeOf(name);
+    asset->etag = etagOf(*asset->content);
+    asset->lastModified = st.st_mtime;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    assets_[name] = std::move(asset);
+    LOG_INFO << "StaticFileCache loaded " << name << " (" << st.st_size << " bytes)";
+}
+
+void StaticFileCache::handleInotify()
+{
+    alignas(struct inotify_event) char buf[4096];
+    while (true)
+    {
+        ssize_t n = ::read(inotifyFd_, buf, sizeof buf);
+        if (n <= 0)
+        {
+            break; // EAGAIN: 事件已读完
+        }
+
+        for (char* p = buf; p < buf + n; )
+        {
+            auto* event = reinterpret_cast<struct inotify_event*>(p);
+            if (event->len > 0)
+            {
+                reload(event->name);
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+} // namespace http
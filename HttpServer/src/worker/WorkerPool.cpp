@@ -0,0 +1,104 @@
+#include "../../include/worker/WorkerPool.h"
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+namespace worker
+{
+
+WorkerPool::WorkerPool(const std::string& name)
+    : name_(name)
+    , maxQueueSize_(0)
+    , running_(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start(int numThreads)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+    {
+        return;
+    }
+    running_ = true;
+    threads_.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i)
+    {
+        threads_.emplace_back(&WorkerPool::runInThread, this);
+    }
+    LOG_INFO << name_ << " started with " << numThreads << " threads";
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    notEmpty_.notify_all();
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+bool WorkerPool::trySubmit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || (maxQueueSize_ > 0 && queue_.size() >= maxQueueSize_))
+        {
+            return false;
+        }
+        queue_.push_back(std::move(task));
+    }
+    notEmpty_.notify_one();
+    return true;
+}
+
+size_t WorkerPool::queueSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void WorkerPool::runInThread()
+{
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this] { return !queue_.empty() || !running_; });
+            if (queue_.empty()) // 线程池已停止且没有剩余任务
+            {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR << name_ << " task threw exception: " << e.what();
+        }
+    }
+}
+
+} // namespace worker
+} // namespace http
@@ -11,6 +11,7 @@
 #include "../../../HttpServer/include/http/HttpServer.h"
 #include "../../../HttpServer/include/utils/MysqlUtil.h"
 #include "../../../HttpServer/include/utils/FileUtil.h"
+#include "../../../HttpServer/include/utils/StaticFileCache.h"
 #include "../../../HttpServer/include/utils/JsonUtil.h"
 
 
@@ -36,6 +37,7 @@ public:
                  muduo::net::TcpServer::Option option = muduo::net::TcpServer::kNoReusePort);
 
     void setThreadNum(int numThreads);
+    void setWorkerThreadNum(int numThreads);
     void start();
 private:
     void initialize();
@@ -60,6 +62,9 @@ private:
                      const std::string& statusMsg, bool close, const std::string& contentType,
                      int contentLen, const std::string& body, http::HttpResponse* resp);
 
+    // 用缓存中的静态页面填充响应，页面不存在时返回 NotFound.html
+    void packageStaticResp(const http::HttpRequest& req, const std::string& fileName, http::HttpResponse* resp);
+
     // 获取历史最高在线人数
     int getMaxOnline() const
     {
@@ -110,6 +115,8 @@ private:
     // 实际业务制定由GomokuServer来完成
     // 需要留意httpServer_提供哪些接口供使用
     http::HttpServer                                 httpServer_;
+    // resource目录下的静态页面，文件变化时自动重新加载
+    http::StaticFileCache                            assetCache_;
     http::MysqlUtil                                  mysqlUtil_;
     // userId -> AiBot
     std::unordered_map<int, std::shared_ptr<AiGame>> aiGames_;
@@ -16,7 +16,9 @@ using namespace http;
 GomokuServer::GomokuServer(int port,
                            const std::string &name,
                            muduo::net::TcpServer::Option option)
-    : httpServer_(port, name, option), maxOnline_(0)
+    : httpServer_(port, name, option)
+    , assetCache_("../WebApps/GomokuServer/resource")
+    , maxOnline_(0)
 {
     initialize();
 }
@@ -26,6 +28,11 @@ void GomokuServer::setThreadNum(int numThreads)
     httpServer_.setThreadNum(numThreads);
 }
 
+void GomokuServer::setWorkerThreadNum(int numThreads)
+{
+    httpServer_.setWorkerThreadNum(numThreads);
+}
+
 void GomokuServer::start()
 {
     httpServer_.start();
@@ -35,6 +42,9 @@ void GomokuServer::initialize()
 {
     // 初始化数据库连接池
     http::MysqlUtil::init("tcp://127.0.0.1:3306", "root", "root", "Gomoku", 10);
+    // 加载静态页面并监听文件变化
+    assetCache_.load();
+    assetCache_.watch(httpServer_.getLoop());
     // 初始化会话
     initializeSession();
     // 初始化中间件
@@ -57,20 +67,24 @@ void GomokuServer::initializeMiddleware()
 {
     // 创建中间件
     auto corsMiddleware = std::make_shared<http::middleware::CorsMiddleware>();
+    // 页面和棋盘JSON压缩后只有原来的1/5到1/10，静态页面的压缩结果会被缓存
+    auto compressionMiddleware = std::make_shared<http::middleware::CompressionMiddleware>();
     // 添加中间件
     httpServer_.addMiddleware(corsMiddleware);
+    httpServer_.addMiddleware(compressionMiddleware);
 }
 
 void GomokuServer::initializeRouter()
 {
     // 注册url回调处理器
+    // 访问数据库或执行AI计算的路由注册为阻塞路由，在工作线程池中执行，避免阻塞IO线程
     // 登录注册入口页面
     httpServer_.Get("/", std::make_shared<EntryHandler>(this));
     httpServer_.Get("/entry", std::make_shared<EntryHandler>(this));
     // 登录
-    httpServer_.Post("/login", std::make_shared<LoginHandler>(this));
+    httpServer_.Post("/login", std::make_shared<LoginHandler>(this), true);
     // 注册
-    httpServer_.Post("/register", std::make_shared<RegisterHandler>(this));
+    httpServer_.Post("/register", std::make_shared<RegisterHandler>(this), true);
     // 登出
     httpServer_.Post("/user/logout", std::make_shared<LogoutHandler>(this));
     // 菜单页面
@@ -78,7 +92,7 @@ void GomokuServer::initializeRouter()
     // 开始对战ai
     httpServer_.Get("/aiBot/start", std::make_shared<AiGameStartHandler>(this));
     // 下棋
-    httpServer_.Post("/aiBot/move", std::make_shared<AiGameMoveHandler>(this));
+    httpServer_.Post("/aiBot/move", std::make_shared<AiGameMoveHandler>(this), true);
     // 重新开始对战ai
     httpServer_.Get("/aiBot/restart", 
     [this](const http::HttpRequest& req, http::HttpResponse* resp) {
@@ -90,7 +104,7 @@ void GomokuServer::initializeRouter()
     // 后台数据获取
     httpServer_.Get("/backend_data", [this](const http::HttpRequest& req, http::HttpResponse* resp) {
         getBackendData(req, resp);
-    });
+    }, true);
 }
 
 void GomokuServer::restartChessGameVsAi(const http::HttpRequest &req, http::HttpResponse *resp)
@@ -218,4 +232,35 @@ void GomokuServer::packageResp(const std::string &version,
         resp->setStatusMessage("Internal Server Error");
         resp->setCloseConnection(true);
     }
-}
\ No newline at end of file
+}
+
+void GomokuServer::packageStaticResp(const http::HttpRequest &req,
+                                     const std::string &fileName,
+                                     http::HttpResponse *resp)
+{
+    http::StaticFileCache::AssetPtr asset = assetCache_.get(fileName);
+    if (asset)
+    {
+        resp->setStatusLine(req.getVersion(), http::HttpResponse::k200Ok, "OK");
+    }
+    else
+    {
+        LOG_WARN << fileName << " not exist";
+        asset = assetCache_.get("NotFound.html");
+        resp->setStatusLine(req.getVersion(), http::HttpResponse::k404NotFound, "Not Found");
+        if (!asset)
+        {
+            resp->setCloseConnection(false);
+            resp->setContentLength(0);
+            return;
+        }
+    }
+
+    resp->setCloseConnection(false);
+    resp->setContentType(asset->contentType);
+    // 浏览器再次访问时带上校验器，未修改的页面由HttpServer直接返回304
+    resp->setETag(asset->etag);
+    resp->setLastModified(asset->lastModified);
+    resp->setContentLength(asset->content->size());
+    resp->setBody(asset->content); // 共享缓存中的内容，不拷贝
+}
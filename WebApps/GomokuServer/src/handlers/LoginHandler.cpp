@@ -4,7 +4,7 @@ void LoginHandler::handle(const http::HttpRequest &req, http::HttpResponse *resp
 {
     // 处理登录逻辑
     // 验证 contentType
-    auto contentType = req.getHeader("Content-Type");
+    auto contentType = req.getHeader(http::HttpHeader::kContentType);
     if (contentType.empty() || contentType != "application/json" || req.getBody().empty())
     {
         LOG_INFO << "content" << req.getBody();
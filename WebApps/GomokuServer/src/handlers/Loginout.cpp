@@ -2,7 +2,7 @@
 
 void LogoutHandler::handle(const http::HttpRequest &req, http::HttpResponse *resp)
 {
-    auto contentType = req.getHeader("Content-Type");
+    auto contentType = req.getHeader(http::HttpHeader::kContentType);
     if (contentType.empty() || contentType != "application/json" || req.getBody().empty())
     {
         resp->setStatusLine(req.getVersion(), http::HttpResponse::k400BadRequest, "Bad Request");
@@ -26,17 +26,14 @@ void MenuHandler::handle(const http::HttpRequest &req, http::HttpResponse *resp)
         int userId = std::stoi(session->getValue("userId"));
         std::string username = session->getValue("username");
 
-        std::string reqFile("../WebApps/GomokuServer/resource/menu.html");
-        FileUtil fileOperater(reqFile);
-        if (!fileOperater.isValid())
+        // 页面需要按用户插入脚本，只能从缓存拷贝一份
+        http::StaticFileCache::AssetPtr asset = server_->assetCache_.get("menu.html");
+        if (!asset)
         {
-            LOG_WARN << reqFile << "not exist.";
-            fileOperater.resetDefaultFile();
+            server_->packageStaticResp(req, "menu.html", resp);
+            return;
         }
-
-        std::vector<char> buffer(fileOperater.size());
-        fileOperater.readFile(buffer); // 读出文件数据
-        std::string htmlContent(buffer.data(), buffer.size());
+        std::string htmlContent(*asset->content);
 
         // 在HTML内容中插入userId
         size_t headEnd = htmlContent.find("</head>");
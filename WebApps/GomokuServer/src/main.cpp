@@ -33,5 +33,6 @@ int main(int argc, char* argv[])
   muduo::Logger::setLogLevel(muduo::Logger::WARN);
   GomokuServer server(port, serverName);
   server.setThreadNum(4);
+  server.setWorkerThreadNum(8);
   server.start();
 }
\ No newline at end of file